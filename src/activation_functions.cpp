@@ -2,10 +2,42 @@
 
 #include <cmath>       // For std::exp, std::tanh (already in .h but good for clarity)
 #include <algorithm>   // For std::max (already in .h but good for clarity)
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>   // For potential error handling if needed in more complex functions
+#include <string>
+
+#include "cpu_features.h"
+
+#if DNN_X86
+#include <immintrin.h>
+#endif
 
 namespace Activations {
 
+    const char* kind_name(Kind kind) {
+        switch (kind) {
+            case Kind::Identity: return "identity";
+            case Kind::Sigmoid: return "sigmoid";
+            case Kind::ReLU: return "relu";
+            case Kind::Tanh: return "tanh";
+        }
+        return "unknown";
+    }
+
+    namespace {
+        std::atomic<Precision> g_precision(Precision::Exact);
+    }
+
+    void set_precision(Precision precision) {
+        g_precision.store(precision, std::memory_order_relaxed);
+    }
+
+    Precision precision() {
+        return g_precision.load(std::memory_order_relaxed);
+    }
+
     // --- Sigmoid ---
     double sigmoid(double x) {
         return 1.0 / (1.0 + std::exp(-x));
@@ -38,4 +70,585 @@ namespace Activations {
         return 1.0 - (activated_output_y * activated_output_y);
     }
 
-} // namespace Activations
\ No newline at end of file
+} // namespace Activations
+
+// --- Batch kernels ---
+//
+// Each elementwise op is a small struct with a scalar form and, for float, AVX2 and
+// AVX-512 forms. The apply_* drivers run an op over (a, b) -> out, where `a` is the
+// activation input/output and `b` an optional upstream gradient. The transcendental
+// forward passes (exp, sigmoid, tanh) use libm in Precision::Exact and the approximation
+// ops below in Precision::Fast.
+namespace Activations {
+
+    namespace {
+
+        void check_sizes(std::size_t a, std::size_t b, const char* what) {
+            if (a != b) {
+                throw std::invalid_argument(std::string(what) + ": input and output spans must have the same size.");
+            }
+        }
+
+        struct ReluOp {
+            template <typename T> static T scalar(T x, T) { return x > T(0) ? x : T(0); }
+#if DNN_X86
+            DNN_TARGET("avx2") static __m256 avx2(__m256 x, __m256) { return _mm256_max_ps(x, _mm256_setzero_ps()); }
+            // Masked move rather than _mm512_max_ps, which trips a GCC 12 -Wmaybe-uninitialized false positive
+            DNN_TARGET("avx512f") static __m512 avx512(__m512 x, __m512) {
+                return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ), x);
+            }
+#endif
+        };
+
+        struct ReluDerivativeOp {
+            template <typename T> static T scalar(T x, T) { return x > T(0) ? T(1) : T(0); }
+#if DNN_X86
+            DNN_TARGET("avx2") static __m256 avx2(__m256 x, __m256) {
+                return _mm256_and_ps(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ), _mm256_set1_ps(1.0f));
+            }
+            DNN_TARGET("avx512f") static __m512 avx512(__m512 x, __m512) {
+                return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ), _mm512_set1_ps(1.0f));
+            }
+#endif
+        };
+
+        struct ReluBackwardOp {
+            template <typename T> static T scalar(T x, T g) { return x > T(0) ? g : T(0); }
+#if DNN_X86
+            DNN_TARGET("avx2") static __m256 avx2(__m256 x, __m256 g) {
+                return _mm256_and_ps(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ), g);
+            }
+            DNN_TARGET("avx512f") static __m512 avx512(__m512 x, __m512 g) {
+                return _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ), g);
+            }
+#endif
+        };
+
+        // S'(x) = y * (1 - y)
+        struct SigmoidDerivativeOp {
+            template <typename T> static T scalar(T y, T) { return y * (T(1) - y); }
+#if DNN_X86
+            DNN_TARGET("avx2") static __m256 avx2(__m256 y, __m256) {
+                return _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.0f), y));
+            }
+            DNN_TARGET("avx512f") static __m512 avx512(__m512 y, __m512) {
+                return _mm512_mul_ps(y, _mm512_sub_ps(_mm512_set1_ps(1.0f), y));
+            }
+#endif
+        };
+
+        struct SigmoidBackwardOp {
+            template <typename T> static T scalar(T y, T g) { return g * (y * (T(1) - y)); }
+#if DNN_X86
+            DNN_TARGET("avx2") static __m256 avx2(__m256 y, __m256 g) {
+                return _mm256_mul_ps(g, SigmoidDerivativeOp::avx2(y, g));
+            }
+            DNN_TARGET("avx512f") static __m512 avx512(__m512 y, __m512 g) {
+                return _mm512_mul_ps(g, SigmoidDerivativeOp::avx512(y, g));
+            }
+#endif
+        };
+
+        // T'(x) = 1 - y^2
+        struct TanhDerivativeOp {
+            template <typename T> static T scalar(T y, T) { return T(1) - y * y; }
+#if DNN_X86
+            DNN_TARGET("avx2") static __m256 avx2(__m256 y, __m256) {
+                return _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(y, y));
+            }
+            DNN_TARGET("avx512f") static __m512 avx512(__m512 y, __m512) {
+                return _mm512_sub_ps(_mm512_set1_ps(1.0f), _mm512_mul_ps(y, y));
+            }
+#endif
+        };
+
+        struct TanhBackwardOp {
+            template <typename T> static T scalar(T y, T g) { return g * (T(1) - y * y); }
+#if DNN_X86
+            DNN_TARGET("avx2") static __m256 avx2(__m256 y, __m256 g) {
+                return _mm256_mul_ps(g, TanhDerivativeOp::avx2(y, g));
+            }
+            DNN_TARGET("avx512f") static __m512 avx512(__m512 y, __m512 g) {
+                return _mm512_mul_ps(g, TanhDerivativeOp::avx512(y, g));
+            }
+#endif
+        };
+
+        // --- Fast approximations (Precision::Fast, float only) ---
+        //
+        // exp: x = n ln2 + r with |r| <= ln2/2 (ln2 split in two for an exact product),
+        // e^r from the Cephes degree-6 polynomial, 2^n built directly in the exponent bits.
+        // tanh: odd degree-13 / even degree-6 rational fit, clamped where it reaches +-1.
+        // The AVX2 forms avoid FMA so they run wherever AVX2 alone is reported.
+        // NaN in gives NaN out on every path. The SIMD clamps rely on max/min returning their
+        // second operand when either is NaN, so x goes second; the scalar exp tests for NaN
+        // explicitly because converting NaN to an integer is undefined.
+        const float kExpHi = 88.3762626647949f;
+        const float kExpLo = -87.3365447505531f; // Keeps 2^n normal
+        const float kLog2e = 1.44269504088896341f;
+        const float kLn2Hi = 0.693359375f;
+        const float kLn2Lo = -2.12194440e-4f;
+        const float kExpP0 = 1.9875691500e-4f;
+        const float kExpP1 = 1.3981999507e-3f;
+        const float kExpP2 = 8.3334519073e-3f;
+        const float kExpP3 = 4.1665795894e-2f;
+        const float kExpP4 = 1.6666665459e-1f;
+        const float kExpP5 = 5.0000001201e-1f;
+
+        const float kTanhClamp = 7.90531110763549805f;
+        const float kTanhTiny = 0.0004f; // tanh(x) rounds to x below this
+        const float kTanhA1 = 4.89352455891786e-03f;
+        const float kTanhA3 = 6.37261928875436e-04f;
+        const float kTanhA5 = 1.48572235717979e-05f;
+        const float kTanhA7 = 5.12229709037114e-08f;
+        const float kTanhA9 = -8.60467152213735e-11f;
+        const float kTanhA11 = 2.00018790482477e-13f;
+        const float kTanhA13 = -2.76076847742355e-16f;
+        const float kTanhB0 = 4.89352518554385e-03f;
+        const float kTanhB2 = 2.26843463243900e-03f;
+        const float kTanhB4 = 1.18534705686654e-04f;
+        const float kTanhB6 = 1.19825839466702e-06f;
+
+        inline float fast_exp(float x) {
+            if (x != x) {
+                return x;
+            }
+            x = std::min(std::max(x, kExpLo), kExpHi);
+            float n = std::nearbyint(x * kLog2e);
+            float r = x - n * kLn2Hi;
+            r = r - n * kLn2Lo;
+            float p = kExpP0;
+            p = p * r + kExpP1;
+            p = p * r + kExpP2;
+            p = p * r + kExpP3;
+            p = p * r + kExpP4;
+            p = p * r + kExpP5;
+            float y = p * (r * r) + r + 1.0f;
+            int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+            float scale;
+            std::memcpy(&scale, &bits, sizeof(scale));
+            return y * scale;
+        }
+
+        inline float fast_tanh(float x) {
+            if (std::fabs(x) < kTanhTiny) {
+                return x;
+            }
+            x = std::min(std::max(x, -kTanhClamp), kTanhClamp);
+            float x2 = x * x;
+            float p = kTanhA13;
+            p = p * x2 + kTanhA11;
+            p = p * x2 + kTanhA9;
+            p = p * x2 + kTanhA7;
+            p = p * x2 + kTanhA5;
+            p = p * x2 + kTanhA3;
+            p = p * x2 + kTanhA1;
+            float q = kTanhB6;
+            q = q * x2 + kTanhB4;
+            q = q * x2 + kTanhB2;
+            q = q * x2 + kTanhB0;
+            return (p * x) / q;
+        }
+
+#if DNN_X86
+        DNN_TARGET("avx2") inline __m256 fast_exp_avx2(__m256 x) {
+            x = _mm256_min_ps(_mm256_set1_ps(kExpHi), _mm256_max_ps(_mm256_set1_ps(kExpLo), x));
+            __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(kLog2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(kLn2Hi)));
+            r = _mm256_sub_ps(r, _mm256_mul_ps(n, _mm256_set1_ps(kLn2Lo)));
+            __m256 p = _mm256_set1_ps(kExpP0);
+            p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kExpP1));
+            p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kExpP2));
+            p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kExpP3));
+            p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kExpP4));
+            p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(kExpP5));
+            __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p, _mm256_mul_ps(r, r)), r), _mm256_set1_ps(1.0f));
+            __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+            return _mm256_mul_ps(y, _mm256_castsi256_ps(bits));
+        }
+
+        DNN_TARGET("avx2") inline __m256 fast_tanh_avx2(__m256 x) {
+            const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+            __m256 tiny = _mm256_cmp_ps(_mm256_andnot_ps(sign_mask, x), _mm256_set1_ps(kTanhTiny), _CMP_LT_OQ);
+            __m256 c = _mm256_min_ps(_mm256_set1_ps(kTanhClamp), _mm256_max_ps(_mm256_set1_ps(-kTanhClamp), x));
+            __m256 x2 = _mm256_mul_ps(c, c);
+            __m256 p = _mm256_set1_ps(kTanhA13);
+            p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(kTanhA11));
+            p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(kTanhA9));
+            p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(kTanhA7));
+            p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(kTanhA5));
+            p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(kTanhA3));
+            p = _mm256_add_ps(_mm256_mul_ps(p, x2), _mm256_set1_ps(kTanhA1));
+            __m256 q = _mm256_set1_ps(kTanhB6);
+            q = _mm256_add_ps(_mm256_mul_ps(q, x2), _mm256_set1_ps(kTanhB4));
+            q = _mm256_add_ps(_mm256_mul_ps(q, x2), _mm256_set1_ps(kTanhB2));
+            q = _mm256_add_ps(_mm256_mul_ps(q, x2), _mm256_set1_ps(kTanhB0));
+            __m256 y = _mm256_div_ps(_mm256_mul_ps(p, c), q);
+            return _mm256_blendv_ps(y, x, tiny);
+        }
+
+        DNN_TARGET("avx512f") inline __m512 fast_exp_avx512(__m512 x) {
+            const __mmask16 all = 0xFFFF;
+            x = _mm512_maskz_min_ps(all, _mm512_set1_ps(kExpHi), _mm512_maskz_max_ps(all, _mm512_set1_ps(kExpLo), x));
+            __m512 n = _mm512_maskz_roundscale_ps(all, _mm512_mul_ps(x, _mm512_set1_ps(kLog2e)),
+                                                  _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(kLn2Hi), x);
+            r = _mm512_fnmadd_ps(n, _mm512_set1_ps(kLn2Lo), r);
+            __m512 p = _mm512_set1_ps(kExpP0);
+            p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP1));
+            p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP2));
+            p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP3));
+            p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP4));
+            p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(kExpP5));
+            __m512 y = _mm512_add_ps(_mm512_fmadd_ps(p, _mm512_mul_ps(r, r), r), _mm512_set1_ps(1.0f));
+            __m512i bits = _mm512_maskz_slli_epi32(all, _mm512_add_epi32(_mm512_maskz_cvtps_epi32(all, n), _mm512_set1_epi32(127)), 23);
+            return _mm512_mul_ps(y, _mm512_castsi512_ps(bits));
+        }
+
+        DNN_TARGET("avx512f") inline __m512 fast_tanh_avx512(__m512 x) {
+            const __mmask16 all = 0xFFFF;
+            __mmask16 tiny = _mm512_cmp_ps_mask(_mm512_abs_ps(x), _mm512_set1_ps(kTanhTiny), _CMP_LT_OQ);
+            __m512 c = _mm512_maskz_min_ps(all, _mm512_set1_ps(kTanhClamp),
+                                          _mm512_maskz_max_ps(all, _mm512_set1_ps(-kTanhClamp), x));
+            __m512 x2 = _mm512_mul_ps(c, c);
+            __m512 p = _mm512_set1_ps(kTanhA13);
+            p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(kTanhA11));
+            p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(kTanhA9));
+            p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(kTanhA7));
+            p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(kTanhA5));
+            p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(kTanhA3));
+            p = _mm512_fmadd_ps(p, x2, _mm512_set1_ps(kTanhA1));
+            __m512 q = _mm512_set1_ps(kTanhB6);
+            q = _mm512_fmadd_ps(q, x2, _mm512_set1_ps(kTanhB4));
+            q = _mm512_fmadd_ps(q, x2, _mm512_set1_ps(kTanhB2));
+            q = _mm512_fmadd_ps(q, x2, _mm512_set1_ps(kTanhB0));
+            __m512 y = _mm512_div_ps(_mm512_mul_ps(p, c), q);
+            return _mm512_mask_mov_ps(y, tiny, x);
+        }
+#endif
+
+        struct ExpFastOp {
+            static float scalar(float x, float) { return fast_exp(x); }
+#if DNN_X86
+            DNN_TARGET("avx2") static __m256 avx2(__m256 x, __m256) { return fast_exp_avx2(x); }
+            DNN_TARGET("avx512f") static __m512 avx512(__m512 x, __m512) { return fast_exp_avx512(x); }
+#endif
+        };
+
+        struct SigmoidFastOp {
+            static float scalar(float x, float) { return 1.0f / (1.0f + fast_exp(-x)); }
+#if DNN_X86
+            DNN_TARGET("avx2") static __m256 avx2(__m256 x, __m256) {
+                const __m256 one = _mm256_set1_ps(1.0f);
+                return _mm256_div_ps(one, _mm256_add_ps(one, fast_exp_avx2(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+            }
+            DNN_TARGET("avx512f") static __m512 avx512(__m512 x, __m512) {
+                const __m512 one = _mm512_set1_ps(1.0f);
+                return _mm512_div_ps(one, _mm512_add_ps(one, fast_exp_avx512(_mm512_sub_ps(_mm512_setzero_ps(), x))));
+            }
+#endif
+        };
+
+        struct TanhFastOp {
+            static float scalar(float x, float) { return fast_tanh(x); }
+#if DNN_X86
+            DNN_TARGET("avx2") static __m256 avx2(__m256 x, __m256) { return fast_tanh_avx2(x); }
+            DNN_TARGET("avx512f") static __m512 avx512(__m512 x, __m512) { return fast_tanh_avx512(x); }
+#endif
+        };
+
+        // `b` may be null for unary ops; the scalar/vector forms then ignore their second argument.
+        template <typename Op, typename T>
+        void apply_scalar(const T* a, const T* b, T* out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = Op::scalar(a[i], b ? b[i] : T(0));
+            }
+        }
+
+#if DNN_X86
+        template <typename Op>
+        DNN_TARGET("avx2") void apply_avx2(const float* a, const float* b, float* out, std::size_t n) {
+            std::size_t i = 0;
+            const __m256 zero = _mm256_setzero_ps();
+            for (; i + 8 <= n; i += 8) {
+                __m256 vb = b ? _mm256_loadu_ps(b + i) : zero;
+                _mm256_storeu_ps(out + i, Op::avx2(_mm256_loadu_ps(a + i), vb));
+            }
+            // GCC may turn the tail into a jump without the usual vzeroupper; a dirty upper
+            // state would slow every later SSE instruction, libm included
+            _mm256_zeroupper();
+            apply_scalar<Op>(a + i, b ? b + i : nullptr, out + i, n - i);
+        }
+
+        template <typename Op>
+        DNN_TARGET("avx512f") void apply_avx512(const float* a, const float* b, float* out, std::size_t n) {
+            std::size_t i = 0;
+            const __m512 zero = _mm512_setzero_ps();
+            for (; i + 16 <= n; i += 16) {
+                __m512 vb = b ? _mm512_loadu_ps(b + i) : zero;
+                _mm512_storeu_ps(out + i, Op::avx512(_mm512_loadu_ps(a + i), vb));
+            }
+            _mm256_zeroupper();
+            apply_scalar<Op>(a + i, b ? b + i : nullptr, out + i, n - i);
+        }
+#endif
+
+        template <typename Op>
+        void apply(const float* a, const float* b, float* out, std::size_t n) {
+#if DNN_X86
+            if (CpuFeatures::has_avx512f()) {
+                apply_avx512<Op>(a, b, out, n);
+                return;
+            }
+            if (CpuFeatures::has_avx2()) {
+                apply_avx2<Op>(a, b, out, n);
+                return;
+            }
+#endif
+            apply_scalar<Op>(a, b, out, n);
+        }
+
+        template <typename Op>
+        void apply(const double* a, const double* b, double* out, std::size_t n) {
+            apply_scalar<Op>(a, b, out, n);
+        }
+
+#if DNN_X86
+        DNN_TARGET("avx2") void relu_with_derivative_avx2(const float* in, float* out, float* derivative, std::size_t n) {
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                __m256 x = _mm256_loadu_ps(in + i);
+                _mm256_storeu_ps(derivative + i, _mm256_and_ps(_mm256_cmp_ps(x, zero, _CMP_GT_OQ), one));
+                _mm256_storeu_ps(out + i, _mm256_max_ps(x, zero));
+            }
+            for (; i < n; ++i) {
+                float x = in[i];
+                derivative[i] = ReluDerivativeOp::scalar(x, 0.0f);
+                out[i] = ReluOp::scalar(x, 0.0f);
+            }
+        }
+
+        DNN_TARGET("avx512f") void relu_with_derivative_avx512(const float* in, float* out, float* derivative, std::size_t n) {
+            const __m512 zero = _mm512_setzero_ps();
+            const __m512 one = _mm512_set1_ps(1.0f);
+            std::size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                __m512 x = _mm512_loadu_ps(in + i);
+                __mmask16 positive = _mm512_cmp_ps_mask(x, zero, _CMP_GT_OQ);
+                _mm512_storeu_ps(derivative + i, _mm512_maskz_mov_ps(positive, one));
+                _mm512_storeu_ps(out + i, _mm512_maskz_mov_ps(positive, x));
+            }
+            for (; i < n; ++i) {
+                float x = in[i];
+                derivative[i] = ReluDerivativeOp::scalar(x, 0.0f);
+                out[i] = ReluOp::scalar(x, 0.0f);
+            }
+        }
+#endif
+
+        // Derivative is written before the output so in-place use (in == out) stays correct.
+        template <typename T>
+        void relu_with_derivative_impl(const T* in, T* out, T* derivative, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                T x = in[i];
+                derivative[i] = ReluDerivativeOp::scalar(x, T(0));
+                out[i] = ReluOp::scalar(x, T(0));
+            }
+        }
+
+        void relu_with_derivative_impl(const float* in, float* out, float* derivative, std::size_t n) {
+#if DNN_X86
+            if (CpuFeatures::has_avx512f()) {
+                relu_with_derivative_avx512(in, out, derivative, n);
+                return;
+            }
+            if (CpuFeatures::has_avx2()) {
+                relu_with_derivative_avx2(in, out, derivative, n);
+                return;
+            }
+#endif
+            relu_with_derivative_impl<float>(in, out, derivative, n);
+        }
+
+        // Forward transcendental kernels: libm for double and Precision::Exact,
+        // the approximation ops for float in Precision::Fast
+        template <typename T>
+        void exp_impl(const T* in, T* out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = std::exp(in[i]);
+            }
+        }
+
+        void exp_impl(const float* in, float* out, std::size_t n) {
+            if (precision() == Precision::Fast) {
+                apply<ExpFastOp>(in, nullptr, out, n);
+                return;
+            }
+            exp_impl<float>(in, out, n);
+        }
+
+        template <typename T>
+        void sigmoid_impl(const T* in, T* out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = T(1) / (T(1) + std::exp(-in[i]));
+            }
+        }
+
+        void sigmoid_impl(const float* in, float* out, std::size_t n) {
+            if (precision() == Precision::Fast) {
+                apply<SigmoidFastOp>(in, nullptr, out, n);
+                return;
+            }
+            sigmoid_impl<float>(in, out, n);
+        }
+
+        template <typename T>
+        void tanh_impl(const T* in, T* out, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = std::tanh(in[i]);
+            }
+        }
+
+        void tanh_impl(const float* in, float* out, std::size_t n) {
+            if (precision() == Precision::Fast) {
+                apply<TanhFastOp>(in, nullptr, out, n);
+                return;
+            }
+            tanh_impl<float>(in, out, n);
+        }
+
+    } // namespace
+
+    template <typename T>
+    void sigmoid(ConstSpan<T> in, Span<T> out) {
+        check_sizes(in.size(), out.size(), "sigmoid");
+        sigmoid_impl(in.data(), out.data(), in.size());
+    }
+
+    template <typename T>
+    void sigmoid_derivative(ConstSpan<T> activated_output_y, Span<T> out) {
+        check_sizes(activated_output_y.size(), out.size(), "sigmoid_derivative");
+        apply<SigmoidDerivativeOp>(activated_output_y.data(), nullptr, out.data(), out.size());
+    }
+
+    template <typename T>
+    void relu(ConstSpan<T> in, Span<T> out) {
+        check_sizes(in.size(), out.size(), "relu");
+        apply<ReluOp>(in.data(), nullptr, out.data(), out.size());
+    }
+
+    template <typename T>
+    void relu_derivative(ConstSpan<T> input_x, Span<T> out) {
+        check_sizes(input_x.size(), out.size(), "relu_derivative");
+        apply<ReluDerivativeOp>(input_x.data(), nullptr, out.data(), out.size());
+    }
+
+    template <typename T>
+    void tanh_activation(ConstSpan<T> in, Span<T> out) {
+        check_sizes(in.size(), out.size(), "tanh_activation");
+        tanh_impl(in.data(), out.data(), in.size());
+    }
+
+    template <typename T>
+    void tanh_derivative(ConstSpan<T> activated_output_y, Span<T> out) {
+        check_sizes(activated_output_y.size(), out.size(), "tanh_derivative");
+        apply<TanhDerivativeOp>(activated_output_y.data(), nullptr, out.data(), out.size());
+    }
+
+    template <typename T>
+    void sigmoid_with_derivative(ConstSpan<T> in, Span<T> out, Span<T> derivative) {
+        check_sizes(in.size(), out.size(), "sigmoid_with_derivative");
+        check_sizes(in.size(), derivative.size(), "sigmoid_with_derivative");
+        // y first, then the derivative from y, so in == out stays correct
+        sigmoid_impl(in.data(), out.data(), in.size());
+        apply<SigmoidDerivativeOp>(out.data(), nullptr, derivative.data(), in.size());
+    }
+
+    template <typename T>
+    void relu_with_derivative(ConstSpan<T> in, Span<T> out, Span<T> derivative) {
+        check_sizes(in.size(), out.size(), "relu_with_derivative");
+        check_sizes(in.size(), derivative.size(), "relu_with_derivative");
+        relu_with_derivative_impl(in.data(), out.data(), derivative.data(), in.size());
+    }
+
+    template <typename T>
+    void tanh_with_derivative(ConstSpan<T> in, Span<T> out, Span<T> derivative) {
+        check_sizes(in.size(), out.size(), "tanh_with_derivative");
+        check_sizes(in.size(), derivative.size(), "tanh_with_derivative");
+        tanh_impl(in.data(), out.data(), in.size());
+        apply<TanhDerivativeOp>(out.data(), nullptr, derivative.data(), in.size());
+    }
+
+    template <typename T>
+    void sigmoid_backward(ConstSpan<T> activated_output_y, Span<T> grad) {
+        check_sizes(activated_output_y.size(), grad.size(), "sigmoid_backward");
+        apply<SigmoidBackwardOp>(activated_output_y.data(), grad.data(), grad.data(), grad.size());
+    }
+
+    template <typename T>
+    void relu_backward(ConstSpan<T> input_x, Span<T> grad) {
+        check_sizes(input_x.size(), grad.size(), "relu_backward");
+        apply<ReluBackwardOp>(input_x.data(), grad.data(), grad.data(), grad.size());
+    }
+
+    template <typename T>
+    void tanh_backward(ConstSpan<T> activated_output_y, Span<T> grad) {
+        check_sizes(activated_output_y.size(), grad.size(), "tanh_backward");
+        apply<TanhBackwardOp>(activated_output_y.data(), grad.data(), grad.data(), grad.size());
+    }
+
+    template <typename T>
+    void softmax(ConstSpan<T> logits, Span<T> out, std::size_t num_classes) {
+        check_sizes(logits.size(), out.size(), "softmax");
+        if (num_classes == 0 || logits.size() % num_classes != 0) {
+            throw std::invalid_argument("softmax: logits size must be a multiple of num_classes.");
+        }
+        for (std::size_t offset = 0; offset < logits.size(); offset += num_classes) {
+            const T* z = logits.data() + offset;
+            T* p = out.data() + offset;
+            T max_z = *std::max_element(z, z + num_classes);
+            for (std::size_t i = 0; i < num_classes; ++i) {
+                p[i] = z[i] - max_z;
+            }
+            exp_impl(p, p, num_classes);
+            T sum = T(0);
+            for (std::size_t i = 0; i < num_classes; ++i) {
+                sum += p[i];
+            }
+            T inv_sum = T(1) / sum;
+            for (std::size_t i = 0; i < num_classes; ++i) {
+                p[i] *= inv_sum;
+            }
+        }
+    }
+
+    template <typename T>
+    void exponential(ConstSpan<T> in, Span<T> out) {
+        check_sizes(in.size(), out.size(), "exponential");
+        exp_impl(in.data(), out.data(), in.size());
+    }
+
+#define DNN_INSTANTIATE_ACTIVATIONS(T)                                                    \
+    template void sigmoid<T>(ConstSpan<T>, Span<T>);                                      \
+    template void sigmoid_derivative<T>(ConstSpan<T>, Span<T>);                           \
+    template void relu<T>(ConstSpan<T>, Span<T>);                                         \
+    template void relu_derivative<T>(ConstSpan<T>, Span<T>);                              \
+    template void tanh_activation<T>(ConstSpan<T>, Span<T>);                              \
+    template void tanh_derivative<T>(ConstSpan<T>, Span<T>);                              \
+    template void sigmoid_with_derivative<T>(ConstSpan<T>, Span<T>, Span<T>);             \
+    template void relu_with_derivative<T>(ConstSpan<T>, Span<T>, Span<T>);                \
+    template void tanh_with_derivative<T>(ConstSpan<T>, Span<T>, Span<T>);                \
+    template void sigmoid_backward<T>(ConstSpan<T>, Span<T>);                             \
+    template void relu_backward<T>(ConstSpan<T>, Span<T>);                                \
+    template void tanh_backward<T>(ConstSpan<T>, Span<T>);                                \
+    template void softmax<T>(ConstSpan<T>, Span<T>, std::size_t);                         \
+    template void exponential<T>(ConstSpan<T>, Span<T>);
+
+    DNN_INSTANTIATE_ACTIVATIONS(float)
+    DNN_INSTANTIATE_ACTIVATIONS(double)
+
+#undef DNN_INSTANTIATE_ACTIVATIONS
+
+} // namespace Activations
@@ -3,11 +3,49 @@
 
 #include <cmath>     // For std::exp, std::tanh
 #include <algorithm> // For std::max (used in ReLU)
+
+#include "span.h"
 // #include <vector> // Will be needed if you add Softmax later
 
 // Using double for precision, can be changed to float if preferred for performance/memory.
 namespace Activations {
 
+    // Identifies an activation when it is selected at runtime (e.g. per layer).
+    // Values are stable: they are stored in saved models.
+    enum class Kind : unsigned char {
+        Identity = 0,
+        Sigmoid = 1,
+        ReLU = 2,
+        Tanh = 3
+    };
+
+    // Human-readable name of an activation kind ("relu", "sigmoid", ...)
+    const char* kind_name(Kind kind);
+
+    // Accuracy mode of the float batch kernels for exp, sigmoid, tanh and softmax (and the
+    // exp inside LossFunctions::softmax_cross_entropy). double kernels are always exact.
+    //   Exact: libm std::exp / std::tanh per element.
+    //   Fast:  vectorized approximations (AVX-512 / AVX2 / scalar); error bounds checked
+    //          by `bench approx` against a double reference:
+    //          exp      range-reduced (x = n ln2 + r), degree-6 polynomial in r; max 1 ULP
+    //                   on [-87.3, 88.3]; inputs are clamped to that range (so results below
+    //                   FLT_MIN flush to ~0 and above ~2^127.5 saturate)
+    //          sigmoid  1 / (1 + fast exp(-x)); max 2 ULP on [-87.3, 87.3], absolute error
+    //                   below 1e-7 everywhere
+    //          tanh     odd/even rational approximation (degree 13 / 6) clamped at |x| = 7.9;
+    //                   max absolute error below 3e-7 (4 ULP for |x| >= 1e-3) on the
+    //                   AVX-512 path, whose FMAs round once per step; the AVX2 and scalar
+    //                   paths stay below 4e-7 (6 ULP)
+    //          All three return NaN for NaN inputs, on every instruction set.
+    // Process-wide and read on every call; switch it between passes, not during one.
+    enum class Precision : unsigned char {
+        Exact = 0,
+        Fast = 1
+    };
+
+    void set_precision(Precision precision);
+    Precision precision();
+
     /**
      * @brief Computes the Sigmoid activation function.
      * S(x) = 1 / (1 + exp(-x))
@@ -57,10 +95,53 @@ namespace Activations {
      */
     double tanh_derivative(double activated_output_y);
 
-    // Note: Softmax is often handled differently as it operates on a vector of scores,
-    // typically in the output layer, and its derivative is more complex (a Jacobian matrix)
-    // or combined with the cross-entropy loss derivative for simplification.
-    // We can add it later if needed, possibly with a different signature.
+    // --- Batch kernels ---
+    // Elementwise versions of the functions above over whole spans, for T = float or double.
+    // `in` and `out` may be the same span (in-place). Sizes must match, otherwise
+    // std::invalid_argument is thrown. float inputs use AVX2/AVX-512 where the CPU supports it.
+
+    template <typename T> void sigmoid(ConstSpan<T> in, Span<T> out);
+    template <typename T> void sigmoid_derivative(ConstSpan<T> activated_output_y, Span<T> out);
+    template <typename T> void relu(ConstSpan<T> in, Span<T> out);
+    template <typename T> void relu_derivative(ConstSpan<T> input_x, Span<T> out);
+    template <typename T> void tanh_activation(ConstSpan<T> in, Span<T> out);
+    template <typename T> void tanh_derivative(ConstSpan<T> activated_output_y, Span<T> out);
+
+    /**
+     * @brief Fused forward pass that also writes the derivative at each point.
+     * out = f(x), derivative = f'(x), in a single sweep over the input.
+     * For ReLU the derivative is the 0/1 mask of x > 0.
+     */
+    template <typename T> void sigmoid_with_derivative(ConstSpan<T> in, Span<T> out, Span<T> derivative);
+    template <typename T> void relu_with_derivative(ConstSpan<T> in, Span<T> out, Span<T> derivative);
+    template <typename T> void tanh_with_derivative(ConstSpan<T> in, Span<T> out, Span<T> derivative);
+
+    /**
+     * @brief Backward pass: multiplies an upstream gradient in place by f'.
+     * grad[i] *= f'(...) where the argument is what the matching *_derivative expects
+     * (activated output for sigmoid/tanh, original input for ReLU).
+     */
+    template <typename T> void sigmoid_backward(ConstSpan<T> activated_output_y, Span<T> grad);
+    template <typename T> void relu_backward(ConstSpan<T> input_x, Span<T> grad);
+    template <typename T> void tanh_backward(ConstSpan<T> activated_output_y, Span<T> grad);
+
+    /**
+     * @brief Row-wise Softmax over a batch of score vectors.
+     * softmax(z)_i = exp(z_i - max(z)) / sum_j exp(z_j - max(z))
+     * Subtracting the row max keeps exp() from overflowing.
+     * Its derivative is a Jacobian, so in practice it is folded into the cross-entropy
+     * gradient (see LossFunctions::softmax_cross_entropy).
+     * @param logits Row-major scores, logits.size() must be a multiple of num_classes.
+     * @param out Probabilities, same size as logits (may alias it).
+     * @param num_classes Length of each row.
+     */
+    template <typename T> void softmax(ConstSpan<T> logits, Span<T> out, std::size_t num_classes);
+
+    /**
+     * @brief Elementwise e^x, honoring the Precision mode for float.
+     * @param out Same size as in (may alias it).
+     */
+    template <typename T> void exponential(ConstSpan<T> in, Span<T> out);
 
 } // namespace Activations
 
@@ -0,0 +1,57 @@
+#include "atomic_file.h"
+
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Makes a rename into path's directory durable
+void sync_directory_of(const std::string& path) {
+    std::string::size_type slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open directory " + dir);
+    }
+    int rc = ::fsync(fd);
+    ::close(fd);
+    if (rc != 0) {
+        throw std::runtime_error("Cannot sync directory " + dir);
+    }
+}
+
+} // namespace
+
+void write_file_atomically(const std::string& path,
+                           const std::function<void(std::FILE* file, const std::string& tmp_path)>& write) {
+    std::string tmp_path = path + ".tmp.XXXXXX";
+    int fd = ::mkstemp(&tmp_path[0]);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + tmp_path);
+    }
+    std::FILE* file = ::fchmod(fd, 0644) == 0 ? ::fdopen(fd, "wb") : nullptr;
+    if (file == nullptr) {
+        ::close(fd);
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Cannot open file: " + tmp_path);
+    }
+    try {
+        write(file, tmp_path);
+        if (std::fflush(file) != 0 || ::fsync(::fileno(file)) != 0) {
+            throw std::runtime_error("Flush failed: " + tmp_path);
+        }
+    } catch (...) {
+        std::fclose(file);
+        std::remove(tmp_path.c_str());
+        throw;
+    }
+    if (std::fclose(file) != 0 || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Cannot replace " + path);
+    }
+    sync_directory_of(path);
+}
@@ -0,0 +1,19 @@
+#ifndef ATOMIC_FILE_H
+#define ATOMIC_FILE_H
+
+#include <cstdio>
+#include <functional>
+#include <string>
+
+/**
+ * @brief Replaces the file at path so readers see either the old file or the complete new one.
+ * write streams the contents to a temporary file from mkstemp, named "<path>.tmp.XXXXXX" and
+ * so unique across threads and processes; it receives that file and its name (for error
+ * messages). The file is then flushed to disk, given mode 0644, renamed over path, and the
+ * directory is synced so the rename itself survives a crash. If write throws, the temporary
+ * file is removed and the exception propagates; I/O failures throw std::runtime_error.
+ */
+void write_file_atomically(const std::string& path,
+                           const std::function<void(std::FILE* file, const std::string& tmp_path)>& write);
+
+#endif // ATOMIC_FILE_H
@@ -0,0 +1,324 @@
+#include "augmentation.h"
+#include "cpu_features.h"
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <stdexcept>
+
+#if DNN_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const float kPi = 3.14159265358979f;
+
+// splitmix64: one 64-bit state, so seeding a generator per sample costs nothing
+struct SampleRng {
+    uint64_t state;
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [lo, hi)
+    float uniform(float lo, float hi) {
+        float u = static_cast<float>(next() >> 40) * (1.0f / 16777216.0f);
+        return lo + (hi - lo) * u;
+    }
+};
+
+// Source coordinate of output pixel (x, y) before the elastic offset:
+// (xx * x + xy * y + x0, yx * x + yy * y + y0)
+struct Affine {
+    float xx, xy, x0;
+    float yx, yy, y0;
+};
+
+// Elastic offsets of one output row: the two upsampled control rows around it and the
+// weight of the lower one, blended per pixel while sampling
+struct ElasticRow {
+    const float* x0;
+    const float* x1;
+    const float* y0;
+    const float* y1;
+    float weight;
+};
+
+// Coordinates are clamped to [-kBorder, size]: every bilinear tap then lands inside the
+// zero-padded source, and anything further out reads the same zeros.
+struct SampleBounds {
+    float min;
+    float max_x;
+    float max_y;
+};
+
+inline unsigned char sample_pixel(const float* padded, std::size_t stride, const SampleBounds& bounds, float sx, float sy) {
+    sx = std::min(std::max(sx, bounds.min), bounds.max_x);
+    sy = std::min(std::max(sy, bounds.min), bounds.max_y);
+    float x0 = std::floor(sx);
+    float y0 = std::floor(sy);
+    float fx = sx - x0;
+    float fy = sy - y0;
+    const std::ptrdiff_t border = static_cast<std::ptrdiff_t>(Augmenter::kBorder);
+    const float* p = padded + (static_cast<std::ptrdiff_t>(y0) + border) * static_cast<std::ptrdiff_t>(stride) +
+                     static_cast<std::ptrdiff_t>(x0) + border;
+    float top = p[0] + fx * (p[1] - p[0]);
+    float bottom = p[stride] + fx * (p[stride + 1] - p[stride]);
+    float v = top + fy * (bottom - top);
+    return static_cast<unsigned char>(static_cast<int>(v + 0.5f));
+}
+
+void sample_row_scalar(const float* padded, std::size_t stride, const SampleBounds& bounds, const Affine& m,
+                       float y, const ElasticRow& e, std::size_t cols, unsigned char* out) {
+    const float bx = m.xy * y + m.x0;
+    const float by = m.yy * y + m.y0;
+    for (std::size_t x = 0; x < cols; ++x) {
+        float fx = static_cast<float>(x);
+        float ex = e.x0[x] + e.weight * (e.x1[x] - e.x0[x]);
+        float ey = e.y0[x] + e.weight * (e.y1[x] - e.y0[x]);
+        out[x] = sample_pixel(padded, stride, bounds, m.xx * fx + bx + ex, m.yx * fx + by + ey);
+    }
+}
+
+void widen_scalar(const unsigned char* src, float* dst, std::size_t begin, std::size_t n) {
+    for (std::size_t x = begin; x < n; ++x) {
+        dst[x] = static_cast<float>(src[x]);
+    }
+}
+
+#if DNN_X86
+// Lanes 2 3 <-> 4 5 of eight floats
+DNN_TARGET("avx2")
+inline __m256 swap_middle_pairs(__m256 v) {
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(v), _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+// Rows of at least 8 pixels. Eight output pixels per step: the bilinear taps of each come from gathers, so the
+// irregular source addresses cost no scalar loads. Same operation order as the scalar
+// path (no FMA), so both produce identical bytes.
+DNN_TARGET("avx2")
+void sample_row_avx2(const float* padded, std::size_t stride, const SampleBounds& bounds, const Affine& m,
+                     float y, const ElasticRow& e, std::size_t cols, unsigned char* out) {
+    const __m256 xx = _mm256_set1_ps(m.xx);
+    const __m256 yx = _mm256_set1_ps(m.yx);
+    const __m256 bx = _mm256_set1_ps(m.xy * y + m.x0);
+    const __m256 by = _mm256_set1_ps(m.yy * y + m.y0);
+    const __m256 weight = _mm256_set1_ps(e.weight);
+    const __m256 lo = _mm256_set1_ps(bounds.min);
+    const __m256 hi_x = _mm256_set1_ps(bounds.max_x);
+    const __m256 hi_y = _mm256_set1_ps(bounds.max_y);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 lanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    const __m256i border = _mm256_set1_epi32(static_cast<int>(Augmenter::kBorder));
+    const __m256i row_stride = _mm256_set1_epi32(static_cast<int>(stride));
+    const long long* top_row = reinterpret_cast<const long long*>(padded);
+    const long long* bottom_row = reinterpret_cast<const long long*>(padded + stride);
+
+    // Rows need not be a multiple of 8 wide (MNIST is 28): the last step is moved back to
+    // end at the row's end, recomputing a few pixels with identical results rather than
+    // finishing on the much slower scalar path
+    for (std::size_t step = 0; step < cols; step += 8) {
+        const std::size_t x = std::min(step, cols - 8);
+        __m256 ex0 = _mm256_loadu_ps(e.x0 + x);
+        __m256 ey0 = _mm256_loadu_ps(e.y0 + x);
+        __m256 ex = _mm256_add_ps(ex0, _mm256_mul_ps(weight, _mm256_sub_ps(_mm256_loadu_ps(e.x1 + x), ex0)));
+        __m256 ey = _mm256_add_ps(ey0, _mm256_mul_ps(weight, _mm256_sub_ps(_mm256_loadu_ps(e.y1 + x), ey0)));
+        __m256 fx = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lanes);
+        __m256 sx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xx, fx), bx), ex);
+        __m256 sy = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(yx, fx), by), ey);
+        sx = _mm256_min_ps(_mm256_max_ps(sx, lo), hi_x);
+        sy = _mm256_min_ps(_mm256_max_ps(sy, lo), hi_y);
+        __m256 x0 = _mm256_floor_ps(sx);
+        __m256 y0 = _mm256_floor_ps(sy);
+        __m256 wx = _mm256_sub_ps(sx, x0);
+        __m256 wy = _mm256_sub_ps(sy, y0);
+        __m256i ix = _mm256_add_epi32(_mm256_cvttps_epi32(x0), border);
+        __m256i iy = _mm256_add_epi32(_mm256_cvttps_epi32(y0), border);
+        __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(iy, row_stride), ix);
+
+        // Horizontally adjacent taps are one 64-bit load: gather (p00, p01) and (p10, p11)
+        // pairs for four pixels at a time, then split them. The split leaves pixels in the
+        // order 0 1 4 5 2 3 6 7, so the weights are permuted to match and the result back.
+        __m128i index_lo = _mm256_castsi256_si128(index);
+        __m128i index_hi = _mm256_extracti128_si256(index, 1);
+        __m256 top_lo = _mm256_castsi256_ps(_mm256_i32gather_epi64(top_row, index_lo, 4));
+        __m256 top_hi = _mm256_castsi256_ps(_mm256_i32gather_epi64(top_row, index_hi, 4));
+        __m256 bottom_lo = _mm256_castsi256_ps(_mm256_i32gather_epi64(bottom_row, index_lo, 4));
+        __m256 bottom_hi = _mm256_castsi256_ps(_mm256_i32gather_epi64(bottom_row, index_hi, 4));
+        __m256 p00 = _mm256_shuffle_ps(top_lo, top_hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 p01 = _mm256_shuffle_ps(top_lo, top_hi, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 p10 = _mm256_shuffle_ps(bottom_lo, bottom_hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 p11 = _mm256_shuffle_ps(bottom_lo, bottom_hi, _MM_SHUFFLE(3, 1, 3, 1));
+        wx = swap_middle_pairs(wx);
+        wy = swap_middle_pairs(wy);
+        __m256 top = _mm256_add_ps(p00, _mm256_mul_ps(wx, _mm256_sub_ps(p01, p00)));
+        __m256 bottom = _mm256_add_ps(p10, _mm256_mul_ps(wx, _mm256_sub_ps(p11, p10)));
+        __m256 v = swap_middle_pairs(_mm256_add_ps(top, _mm256_mul_ps(wy, _mm256_sub_ps(bottom, top))));
+
+        __m256i q = _mm256_cvttps_epi32(_mm256_add_ps(v, half));
+        __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(words, words));
+    }
+    _mm256_zeroupper();
+}
+
+DNN_TARGET("avx2")
+void widen_avx2(const unsigned char* src, float* dst, std::size_t n) {
+    std::size_t x = 0;
+    for (; x + 8 <= n; x += 8) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x));
+        _mm256_storeu_ps(dst + x, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes)));
+    }
+    _mm256_zeroupper();
+    widen_scalar(src, dst, x, n);
+}
+#endif
+
+// Grid cell of each of n output coordinates on a grid of `cells` cells spanning them, and
+// the coordinate's weight towards the cell's far edge
+void grid_taps(std::size_t n, std::size_t cells, std::vector<uint32_t>& cell, std::vector<float>& weight) {
+    const float step = static_cast<float>(cells) / static_cast<float>(n - 1);
+    cell.resize(n);
+    weight.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        float g = static_cast<float>(i) * step;
+        std::size_t c = std::min(static_cast<std::size_t>(g), cells - 1);
+        cell[i] = static_cast<uint32_t>(c);
+        weight[i] = g - static_cast<float>(c);
+    }
+}
+
+// First half of the separable bilinear upsampling of a points x points control grid:
+// each control row interpolated across the image width. The sampler blends two of these
+// rows per image row.
+void upsample_across(const float* control, std::size_t points, const std::vector<uint32_t>& cell_x,
+                     const std::vector<float>& weight_x, float* across) {
+    const std::size_t cols = cell_x.size();
+    for (std::size_t j = 0; j < points; ++j) {
+        const float* c = control + j * points;
+        float* a = across + j * cols;
+        for (std::size_t x = 0; x < cols; ++x) {
+            a[x] = c[cell_x[x]] + weight_x[x] * (c[cell_x[x] + 1] - c[cell_x[x]]);
+        }
+    }
+}
+
+} // namespace
+
+Augmenter::Augmenter(std::size_t rows, std::size_t cols, const AugmentConfig& config)
+    : rows_(rows), cols_(cols), config_(config) {
+    if (rows_ < 2 || cols_ < 2) {
+        throw std::invalid_argument("Augmenter: images must be at least 2x2.");
+    }
+    if (!(config_.min_scale > 0.0f) || config_.min_scale > config_.max_scale) {
+        throw std::invalid_argument("Augmenter: scale range must be positive and ordered.");
+    }
+    if (config_.elastic_grid == 0) {
+        throw std::invalid_argument("Augmenter: elastic_grid must be non-zero.");
+    }
+    grid_taps(cols_, config_.elastic_grid, cell_x_, weight_x_);
+    grid_taps(rows_, config_.elastic_grid, cell_y_, weight_y_);
+}
+
+Augmenter::Scratch Augmenter::make_scratch() const {
+    const std::size_t points = config_.elastic_grid + 1;
+    Scratch scratch;
+    // The border is written once here and never touched again
+    scratch.padded.assign((rows_ + 2 * kBorder) * (cols_ + 2 * kBorder), 0.0f);
+    scratch.control.assign(points * points, 0.0f);
+    // Stay zero when the elastic stage is disabled
+    scratch.across_x.assign(points * cols_, 0.0f);
+    scratch.across_y.assign(points * cols_, 0.0f);
+    return scratch;
+}
+
+void Augmenter::augment(const unsigned char* in, unsigned char* out, std::size_t epoch, std::size_t sample,
+                        Scratch& scratch) const {
+    SampleRng rng = {(static_cast<uint64_t>(config_.seed) << 32) ^ (static_cast<uint64_t>(epoch) * 0xD1B54A32D192ED03ULL) ^
+                     (static_cast<uint64_t>(sample) * 0x9E3779B97F4A7C15ULL)};
+    rng.next();
+
+    const float theta = rng.uniform(-config_.max_rotation_degrees, config_.max_rotation_degrees) * (kPi / 180.0f);
+    const float scale = rng.uniform(config_.min_scale, config_.max_scale);
+    const float shift_x = rng.uniform(-config_.max_shift, config_.max_shift);
+    const float shift_y = rng.uniform(-config_.max_shift, config_.max_shift);
+    if (config_.elastic_alpha > 0.0f) {
+        const float alpha = config_.elastic_alpha;
+        for (std::vector<float>* across : {&scratch.across_x, &scratch.across_y}) {
+            for (float& c : scratch.control) {
+                c = rng.uniform(-alpha, alpha);
+            }
+            upsample_across(scratch.control.data(), config_.elastic_grid + 1, cell_x_, weight_x_, across->data());
+        }
+    }
+
+    // Inverse map: output pixel p samples the source at c + (R(theta) / scale) (p - c) + t
+    const float cx = 0.5f * static_cast<float>(cols_ - 1);
+    const float cy = 0.5f * static_cast<float>(rows_ - 1);
+    const float c = std::cos(theta) / scale;
+    const float s = std::sin(theta) / scale;
+    Affine m;
+    m.xx = c;
+    m.xy = -s;
+    m.x0 = cx + shift_x - c * cx + s * cy;
+    m.yx = s;
+    m.yy = c;
+    m.y0 = cy + shift_y - s * cx - c * cy;
+
+    SampleBounds bounds;
+    bounds.min = -static_cast<float>(kBorder);
+    bounds.max_x = static_cast<float>(cols_);
+    bounds.max_y = static_cast<float>(rows_);
+    const std::size_t stride = cols_ + 2 * kBorder;
+    float* padded = scratch.padded.data();
+#if DNN_X86
+    const bool vectorized = CpuFeatures::has_avx2() && cols_ >= 8;
+#endif
+
+    for (std::size_t y = 0; y < rows_; ++y) {
+        float* dst = padded + (y + kBorder) * stride + kBorder;
+#if DNN_X86
+        if (vectorized) {
+            widen_avx2(in + y * cols_, dst, cols_);
+            continue;
+        }
+#endif
+        widen_scalar(in + y * cols_, dst, 0, cols_);
+    }
+
+    for (std::size_t y = 0; y < rows_; ++y) {
+        ElasticRow e;
+        e.x0 = scratch.across_x.data() + cell_y_[y] * cols_;
+        e.x1 = e.x0 + cols_;
+        e.y0 = scratch.across_y.data() + cell_y_[y] * cols_;
+        e.y1 = e.y0 + cols_;
+        e.weight = weight_y_[y];
+#if DNN_X86
+        if (vectorized) {
+            sample_row_avx2(padded, stride, bounds, m, static_cast<float>(y), e, cols_, out + y * cols_);
+            continue;
+        }
+#endif
+        sample_row_scalar(padded, stride, bounds, m, static_cast<float>(y), e, cols_, out + y * cols_);
+    }
+}
+
+void Augmenter::augment_batch(const unsigned char* const* sources, const std::size_t* samples, std::size_t n,
+                              std::size_t epoch, unsigned char* out, ThreadPool& pool,
+                              std::vector<Scratch>& scratch) const {
+    if (scratch.size() < pool.size()) {
+        throw std::invalid_argument("Augmenter::augment_batch: need one scratch per pool thread.");
+    }
+    const std::size_t threads = pool.size();
+    const std::size_t width = image_size();
+    pool.run([&](std::size_t t) {
+        for (std::size_t i = t * n / threads; i < (t + 1) * n / threads; ++i) {
+            augment(sources[i], out + i * width, epoch, samples[i], scratch[t]);
+        }
+    });
+}
@@ -0,0 +1,73 @@
+#ifndef AUGMENTATION_H
+#define AUGMENTATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "thread_pool.h"
+
+// Ranges of the random distortions, drawn uniformly per sample
+struct AugmentConfig {
+    float max_rotation_degrees = 12.0f;
+    float min_scale = 0.9f;
+    float max_scale = 1.1f;
+    float max_shift = 2.0f;      // Pixels, each axis
+    float elastic_alpha = 1.5f;  // Peak elastic displacement in pixels; 0 disables it
+    std::size_t elastic_grid = 4; // Cells per side of the elastic control grid
+    uint32_t seed = 1;
+};
+
+// On-the-fly distortion of u8 images, applied to raw pixels before normalization.
+// Each output pixel is bilinearly sampled from the source at
+//     c + (R(theta) / s) (p - c) + t + e(p)
+// where c is the image centre, theta/s/t a random rotation, scale and shift, and e an
+// elastic displacement field. The field is bilinearly interpolated from a coarse grid of
+// random control displacements, a cheap stand-in for the Gaussian-smoothed noise field of
+// Simard et al. Pixels sampled from outside the source read as 0.
+//
+// Every draw comes from a generator seeded with (config.seed, epoch, sample index), so a
+// sample's distortion does not depend on which thread or batch produced it.
+class Augmenter {
+public:
+    Augmenter(std::size_t rows, std::size_t cols, const AugmentConfig& config);
+
+    std::size_t image_size() const { return rows_ * cols_; }
+    const AugmentConfig& config() const { return config_; }
+
+    // Per-thread working memory for augment()
+    struct Scratch {
+        std::vector<float> padded;   // Source as float with a zero border of kBorder pixels
+        std::vector<float> control;  // Elastic control displacements for one axis
+        std::vector<float> across_x; // Control rows interpolated across the width, per axis
+        std::vector<float> across_y;
+    };
+    Scratch make_scratch() const;
+
+    // Writes the distorted version of one image (image_size() bytes) to out
+    void augment(const unsigned char* in, unsigned char* out, std::size_t epoch, std::size_t sample,
+                 Scratch& scratch) const;
+
+    /**
+     * @brief Distorts n images across pool; out receives them contiguously.
+     * @param sources sources[i] is image i's pixels.
+     * @param samples samples[i] is image i's dataset index, which seeds its distortion.
+     * scratch must hold one entry per pool thread.
+     */
+    void augment_batch(const unsigned char* const* sources, const std::size_t* samples, std::size_t n,
+                       std::size_t epoch, unsigned char* out, ThreadPool& pool, std::vector<Scratch>& scratch) const;
+
+    static const std::size_t kBorder = 2;
+
+private:
+    std::size_t rows_;
+    std::size_t cols_;
+    AugmentConfig config_;
+    // Elastic grid cell and interpolation weight of every column and row
+    std::vector<uint32_t> cell_x_;
+    std::vector<float> weight_x_;
+    std::vector<uint32_t> cell_y_;
+    std::vector<float> weight_y_;
+};
+
+#endif // AUGMENTATION_H
@@ -0,0 +1,1667 @@
+#include "data_processor.h"
+#include "gemm.h"
+#include "loss_functions.h"
+#include "mnist_reader.h"
+#include "neural_network.h"
+#include "activation_functions.h"
+#include "augmentation.h"
+#include "bench_harness.h"
+#include "checkpoint.h"
+#include "cpu_features.h"
+#include "data_loader.h"
+#include "dataset_cache.h"
+#include "evaluator.h"
+#include "inference_server.h"
+#include "optimizer.h"
+#include "profiler.h"
+#include "quantized_network.h"
+#include "static_network.h"
+#include "tensor.h"
+#include "trainer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void fill_random(Tensor2D<float>& t, std::mt19937& rng) {
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (std::size_t i = 0; i < t.size(); ++i) {
+        t.data()[i] = dist(rng);
+    }
+}
+
+struct GemmShape {
+    const char* name;
+    bool trans_a;
+    bool trans_b;
+    std::size_t M, N, K;
+};
+
+// --- GEMM: the products a 784 -> 128 -> 10 dense network needs per mini-batch ---
+void bench_gemm() {
+    const std::size_t batch = 256;
+    const GemmShape shapes[] = {
+        {"fwd  784->128 (XW)",   false, false, batch, 128, 784},
+        {"fwd  128->10  (XW)",   false, false, batch, 10, 128},
+        {"dW   784x128 (X^T dY)", true, false, 784, 128, batch},
+        {"dW   128x10  (X^T dY)", true, false, 128, 10, batch},
+        {"dX   128<-10 (dY W^T)", false, true, batch, 128, 10},
+        {"dX   784<-128 (dY W^T)", false, true, batch, 784, 128},
+        {"square 512",            false, false, 512, 512, 512},
+    };
+
+    std::mt19937 rng(42);
+    std::printf("GEMM benchmark (batch %zu), best of repetitions\n", batch);
+    std::printf("%-24s %10s %10s %12s %10s\n", "shape", "ms", "GFLOP/s", "naive GF/s", "max err");
+    for (const GemmShape& s : shapes) {
+        Tensor2D<float> A(s.trans_a ? s.K : s.M, s.trans_a ? s.M : s.K);
+        Tensor2D<float> B(s.trans_b ? s.N : s.K, s.trans_b ? s.K : s.N);
+        Tensor2D<float> C(s.M, s.N);
+        Tensor2D<float> C_ref(s.M, s.N);
+        fill_random(A, rng);
+        fill_random(B, rng);
+
+        double flops = 2.0 * s.M * s.N * s.K;
+        int reps = std::max(3, static_cast<int>(2e9 / flops));
+
+        double best = 1e30;
+        for (int r = 0; r < reps; ++r) {
+            Clock::time_point start = Clock::now();
+            Gemm::sgemm(s.trans_a, s.trans_b, s.M, s.N, s.K, 1.0f, A.data(), A.cols(), B.data(), B.cols(),
+                        0.0f, C.data(), C.cols());
+            best = std::min(best, seconds_since(start));
+        }
+
+        Clock::time_point start = Clock::now();
+        Gemm::sgemm_reference(s.trans_a, s.trans_b, s.M, s.N, s.K, 1.0f, A.data(), A.cols(), B.data(), B.cols(),
+                              0.0f, C_ref.data(), C_ref.cols());
+        double naive = seconds_since(start);
+
+        float max_err = 0.0f;
+        for (std::size_t i = 0; i < C.size(); ++i) {
+            max_err = std::max(max_err, std::fabs(C.data()[i] - C_ref.data()[i]));
+        }
+        std::printf("%-24s %10.4f %10.2f %12.2f %10.2e\n", s.name, best * 1e3, flops / best * 1e-9,
+                    flops / naive * 1e-9, max_err);
+    }
+}
+
+// --- Trainer scaling: samples/sec for one epoch at 1..N threads ---
+// Uses the given IDX files if provided, otherwise 60k synthetic images of the same shape.
+void bench_train_scaling(int argc, char** argv) {
+    Batch images;
+    std::vector<unsigned char> labels;
+    if (argc >= 4) {
+        MnistImageView view(argv[2]);
+        DataProcessor processor;
+        images = processor.process_images(view);
+        labels = read_mnist_labels(argv[3]);
+    } else {
+        std::mt19937 rng(7);
+        std::vector<unsigned char> pixels(60000 * 784);
+        for (unsigned char& p : pixels) {
+            p = static_cast<unsigned char>(rng() & 0xff);
+        }
+        DataProcessor processor;
+        processor.process_images_into(Span<const unsigned char>(pixels), 784, images);
+        labels.resize(60000);
+        for (unsigned char& l : labels) {
+            l = static_cast<unsigned char>(rng() % 10);
+        }
+    }
+
+    std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("Trainer scaling: %zu images, 784-128-10 ReLU, batch 256\n", images.rows());
+    std::printf("%8s %14s %10s\n", "threads", "samples/s", "speedup");
+    double base = 0.0;
+    for (std::size_t threads = 1; threads <= max_threads; threads = (threads < 4) ? threads + 1 : threads * 2) {
+        NeuralNetwork network({784, 128, 10}, Activations::Kind::ReLU, 1);
+        SgdOptimizer optimizer(0.05f, 0.9f);
+        TrainerConfig config;
+        config.batch_size = 256;
+        config.num_threads = threads;
+        Trainer trainer(network, optimizer, config);
+        EpochStats stats = trainer.train_epoch(images, labels);
+        if (threads == 1) {
+            base = stats.samples_per_second;
+        }
+        std::printf("%8zu %14.0f %9.2fx\n", threads, stats.samples_per_second, stats.samples_per_second / base);
+    }
+}
+
+bool file_exists(const char* path) {
+    return std::ifstream(path).good();
+}
+
+// Class-dependent synthetic digits: each label has a random prototype image and samples are
+// noisy copies of it, so a network can learn them (unlike uniformly random pixels)
+void make_synthetic_digits(std::size_t count, uint32_t seed, Batch& images, std::vector<unsigned char>& labels) {
+    std::mt19937 rng(1000); // Prototypes are shared by every call
+    std::vector<float> prototypes(10 * 784);
+    for (float& p : prototypes) {
+        p = (rng() % 4 == 0) ? 1.0f : 0.0f;
+    }
+    rng.seed(seed);
+    std::uniform_real_distribution<float> noise(-3.5f, 3.5f);
+    images.resize(count, 784);
+    labels.resize(count);
+    for (std::size_t n = 0; n < count; ++n) {
+        labels[n] = static_cast<unsigned char>(rng() % 10);
+        for (std::size_t i = 0; i < 784; ++i) {
+            images(n, i) = std::min(1.0f, std::max(0.0f, prototypes[labels[n] * 784 + i] + noise(rng)));
+        }
+    }
+}
+
+// --- INT8 vs FP32 inference: accuracy on the test set and throughput ---
+// Defaults to the model main.cpp saves and the t10k files; falls back to training a
+// quick model on synthetic digits when those are not available.
+void bench_int8(int argc, char** argv) {
+    const char* model_path = (argc > 2) ? argv[2] : "mnist_model.ckpt";
+    const char* images_path = (argc > 3) ? argv[3] : "../data/t10k-images-idx3-ubyte/t10k-images-idx3-ubyte";
+    const char* labels_path = (argc > 4) ? argv[4] : "../data/t10k-labels-idx1-ubyte/t10k-labels-idx1-ubyte";
+
+    std::vector<unsigned char> pixels;
+    std::vector<unsigned char> labels;
+    NeuralNetwork network;
+    if (file_exists(model_path) && file_exists(images_path) && file_exists(labels_path)) {
+        network = Checkpoint::load(model_path);
+        MnistImageView view(images_path);
+        pixels.assign(view.pixels().begin(), view.pixels().end());
+        labels = read_mnist_labels(labels_path);
+        std::printf("INT8 report: %s on %s\n", model_path, images_path);
+    } else {
+        // Quantized input is raw u8 pixels, so take the shared synthetic digits back to bytes
+        Batch digits;
+        make_synthetic_digits(20000, 11, digits, labels);
+        pixels.resize(digits.size());
+        for (std::size_t i = 0; i < pixels.size(); ++i) {
+            pixels[i] = static_cast<unsigned char>(std::lround(digits.data()[i] * 255.0f));
+        }
+        Batch train;
+        DataProcessor processor;
+        processor.process_images_into(Span<const unsigned char>(pixels.data(), 10000 * 784), 784, train);
+        network = NeuralNetwork({784, 128, 10}, Activations::Kind::ReLU, 3);
+        SgdOptimizer optimizer(0.05f, 0.9f);
+        TrainerConfig config;
+        Trainer trainer(network, optimizer, config);
+        trainer.train_epoch(train, Span<const unsigned char>(labels.data(), 10000));
+        pixels.erase(pixels.begin(), pixels.begin() + 10000 * 784);
+        labels.erase(labels.begin(), labels.begin() + 10000);
+        std::printf("INT8 report: synthetic data (no model/test set found)\n");
+    }
+
+    const std::size_t count = labels.size();
+    const std::size_t batch = 256;
+    QuantizedNetwork quantized(network, Span<const unsigned char>(pixels.data(), std::min<std::size_t>(count, 2048) * 784));
+
+    std::vector<unsigned char> fp32_classes(count);
+    std::vector<unsigned char> int8_classes(count);
+    DataProcessor processor;
+    Batch inputs;
+    PassBuffers buffers;
+    QuantizedBuffers qbuffers;
+
+    // FP32 timing includes the u8 -> f32 normalization the INT8 path skips
+    Clock::time_point start = Clock::now();
+    for (std::size_t offset = 0; offset < count; offset += batch) {
+        std::size_t rows = std::min(batch, count - offset);
+        processor.process_images_into(Span<const unsigned char>(pixels.data() + offset * 784, rows * 784), 784, inputs);
+        argmax_rows(network.forward(inputs, buffers), Span<unsigned char>(fp32_classes.data() + offset, rows));
+    }
+    double fp32_seconds = seconds_since(start);
+
+    start = Clock::now();
+    for (std::size_t offset = 0; offset < count; offset += batch) {
+        std::size_t rows = std::min(batch, count - offset);
+        quantized.predict(Span<const unsigned char>(pixels.data() + offset * 784, rows * 784),
+                          Span<unsigned char>(int8_classes.data() + offset, rows), qbuffers);
+    }
+    double int8_seconds = seconds_since(start);
+
+    std::size_t fp32_correct = 0, int8_correct = 0, agree = 0;
+    for (std::size_t n = 0; n < count; ++n) {
+        fp32_correct += (fp32_classes[n] == labels[n]);
+        int8_correct += (int8_classes[n] == labels[n]);
+        agree += (fp32_classes[n] == int8_classes[n]);
+    }
+    std::size_t fp32_bytes = 0;
+    for (const DenseLayer& layer : network.layers()) {
+        fp32_bytes += (layer.weights().size() + layer.biases().size()) * sizeof(float);
+    }
+
+    std::printf("%-6s %10s %14s %14s\n", "path", "accuracy", "images/s", "param bytes");
+    std::printf("%-6s %9.2f%% %14.0f %14zu\n", "fp32", 100.0 * fp32_correct / count, count / fp32_seconds, fp32_bytes);
+    std::printf("%-6s %9.2f%% %14.0f %14zu\n", "int8", 100.0 * int8_correct / count, count / int8_seconds,
+                quantized.parameter_bytes());
+    std::printf("prediction agreement: %.2f%% over %zu images\n", 100.0 * agree / count, count);
+}
+
+// Writes an IDX3 image file and matching IDX1 label file. Pixels are ~80% zeros like
+// real MNIST; labels are uniform digits.
+void write_synthetic_idx(const std::string& images_path, const std::string& labels_path, std::size_t count) {
+    std::mt19937 rng(1234);
+    auto put_be32 = [](std::ofstream& out, uint32_t v) {
+        unsigned char b[4] = {static_cast<unsigned char>(v >> 24), static_cast<unsigned char>(v >> 16),
+                              static_cast<unsigned char>(v >> 8), static_cast<unsigned char>(v)};
+        out.write(reinterpret_cast<const char*>(b), 4);
+    };
+
+    std::ofstream images(images_path, std::ios::binary);
+    put_be32(images, 2051);
+    put_be32(images, static_cast<uint32_t>(count));
+    put_be32(images, 28);
+    put_be32(images, 28);
+    std::vector<unsigned char> pixels(784);
+    for (std::size_t n = 0; n < count; ++n) {
+        for (unsigned char& p : pixels) {
+            p = (rng() % 5 == 0) ? static_cast<unsigned char>(rng() & 0xff) : 0;
+        }
+        images.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+    }
+
+    std::ofstream labels(labels_path, std::ios::binary);
+    put_be32(labels, 2049);
+    put_be32(labels, static_cast<uint32_t>(count));
+    for (std::size_t n = 0; n < count; ++n) {
+        char label = static_cast<char>(rng() % 10);
+        labels.write(&label, 1);
+    }
+    if (!images || !labels) {
+        throw std::runtime_error("Cannot write synthetic IDX files to " + images_path);
+    }
+}
+
+// mkdtemp directory for a suite's synthetic files; it and everything in it are removed
+// when the suite returns or throws
+class ScratchDir {
+public:
+    ScratchDir() {
+        char dir_template[] = "/tmp/dnn_bench_XXXXXX";
+        if (mkdtemp(dir_template) == nullptr) {
+            throw std::runtime_error("Cannot create a temporary directory for synthetic files.");
+        }
+        path_ = dir_template;
+    }
+
+    ~ScratchDir() {
+        if (DIR* dir = ::opendir(path_.c_str())) {
+            while (dirent* entry = ::readdir(dir)) {
+                if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) {
+                    std::remove(file(entry->d_name).c_str());
+                }
+            }
+            ::closedir(dir);
+        }
+        ::rmdir(path_.c_str());
+    }
+
+    ScratchDir(const ScratchDir&) = delete;
+    ScratchDir& operator=(const ScratchDir&) = delete;
+
+    std::string file(const std::string& name) const { return path_ + "/" + name; }
+
+private:
+    std::string path_;
+};
+
+// --- Every existing module: reader, processor, activations, losses ---
+// Usage: bench modules [--json out.json] [--reps N]
+void bench_modules(int argc, char** argv) {
+    std::string json_path;
+    std::size_t reps = 10;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--json") == 0) {
+            json_path = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--reps") == 0) {
+            char* end = nullptr;
+            reps = std::strtoull(argv[i + 1], &end, 10);
+            if (end == argv[i + 1] || *end != '\0' || argv[i + 1][0] == '-' || reps == 0) {
+                throw std::invalid_argument(std::string("bench modules: --reps must be a positive integer, got ") +
+                                            argv[i + 1]);
+            }
+        }
+    }
+
+    // The repository ships no image files, so generate a 60k-image set to read back
+    ScratchDir fixtures;
+    const std::string images_path = fixtures.file("images-idx3-ubyte");
+    const std::string labels_path = fixtures.file("labels-idx1-ubyte");
+    const std::size_t count = 60000;
+    write_synthetic_idx(images_path, labels_path, count);
+    const double image_file_bytes = 16.0 + count * 784.0;
+    const double label_file_bytes = 8.0 + count;
+
+    BenchSuite suite("modules", reps);
+
+    // mnist_reader
+    suite.run("mnist_reader/read_mnist_images", 1, image_file_bytes,
+              [&]() { do_not_optimize(read_mnist_images(images_path)); });
+    suite.run("mnist_reader/read_mnist_labels", 1, label_file_bytes,
+              [&]() { do_not_optimize(read_mnist_labels(labels_path)); });
+    suite.run("mnist_reader/MnistImageView (mmap)", 1, image_file_bytes, [&]() {
+        MnistImageView view(images_path);
+        do_not_optimize(view.image(count - 1)[0]);
+    });
+
+    // data_processor (one op = one image / label)
+    std::vector<std::vector<unsigned char>> raw_images = read_mnist_images(images_path);
+    std::vector<unsigned char> raw_labels = read_mnist_labels(labels_path);
+    MnistImageView view(images_path);
+    DataProcessor processor;
+    Batch batch;
+    suite.run("data_processor/process_images (nested vectors)", count, 784,
+              [&]() { do_not_optimize(processor.process_images(raw_images)); });
+    suite.run("data_processor/process_images_into (Batch)", count, 784,
+              [&]() { processor.process_images_into(view.pixels(), view.image_size(), batch); do_not_optimize(batch.data()[0]); });
+    suite.run("data_processor/process_labels", count, 1,
+              [&]() { do_not_optimize(processor.process_labels(raw_labels)); });
+
+    // activation_functions (one op = one element)
+    const std::size_t n = 1 << 20;
+    std::mt19937 rng(5);
+    std::normal_distribution<float> dist(0.0f, 2.0f);
+    std::vector<double> xd(n), yd(n);
+    std::vector<float> xf(n), yf(n), df(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        xf[i] = dist(rng);
+        xd[i] = xf[i];
+    }
+    struct ScalarActivation {
+        const char* name;
+        double (*fn)(double);
+    };
+    const ScalarActivation scalar_activations[] = {
+        {"activations/sigmoid (scalar double)", Activations::sigmoid},
+        {"activations/sigmoid_derivative (scalar double)", Activations::sigmoid_derivative},
+        {"activations/relu (scalar double)", Activations::relu},
+        {"activations/relu_derivative (scalar double)", Activations::relu_derivative},
+        {"activations/tanh_activation (scalar double)", Activations::tanh_activation},
+        {"activations/tanh_derivative (scalar double)", Activations::tanh_derivative},
+    };
+    for (const ScalarActivation& a : scalar_activations) {
+        suite.run(a.name, n, 2 * sizeof(double), [&]() {
+            for (std::size_t i = 0; i < n; ++i) {
+                yd[i] = a.fn(xd[i]);
+            }
+            do_not_optimize(yd[n - 1]);
+        });
+    }
+    Span<float> y(yf), d(df);
+    suite.run("activations/sigmoid<float>", n, 8, [&]() { Activations::sigmoid<float>(xf, y); });
+    suite.run("activations/sigmoid_derivative<float>", n, 8, [&]() { Activations::sigmoid_derivative<float>(xf, y); });
+    suite.run("activations/relu<float>", n, 8, [&]() { Activations::relu<float>(xf, y); });
+    suite.run("activations/relu_derivative<float>", n, 8, [&]() { Activations::relu_derivative<float>(xf, y); });
+    suite.run("activations/tanh_activation<float>", n, 8, [&]() { Activations::tanh_activation<float>(xf, y); });
+    suite.run("activations/tanh_derivative<float>", n, 8, [&]() { Activations::tanh_derivative<float>(xf, y); });
+    suite.run("activations/sigmoid_with_derivative<float>", n, 12, [&]() { Activations::sigmoid_with_derivative<float>(xf, y, d); });
+    suite.run("activations/relu_with_derivative<float>", n, 12, [&]() { Activations::relu_with_derivative<float>(xf, y, d); });
+    suite.run("activations/tanh_with_derivative<float>", n, 12, [&]() { Activations::tanh_with_derivative<float>(xf, y, d); });
+    suite.run("activations/relu_backward<float>", n, 12, [&]() { Activations::relu_backward<float>(xf, y); });
+    suite.run("activations/sigmoid_backward<float>", n, 12, [&]() { Activations::sigmoid_backward<float>(xf, y); });
+    suite.run("activations/tanh_backward<float>", n, 12, [&]() { Activations::tanh_backward<float>(xf, y); });
+    suite.run("activations/relu<double>", n, 16, [&]() { Activations::relu<double>(xd, yd); });
+    suite.run("activations/softmax<float> (10 classes)", n / 10, 80,
+              [&]() { Activations::softmax<float>(Span<const float>(xf.data(), n / 10 * 10), Span<float>(yf.data(), n / 10 * 10), 10); });
+
+    // loss_functions (one op = one 10-class sample)
+    const std::size_t samples = 100000;
+    std::vector<double> predictions(10, 0.01), targets(10, 0.0);
+    predictions[3] = 0.91;
+    targets[3] = 1.0;
+    suite.run("loss/mean_squared_error", samples, 160, [&]() {
+        for (std::size_t i = 0; i < samples; ++i) do_not_optimize(LossFunctions::mean_squared_error(predictions, targets));
+    });
+    suite.run("loss/mean_squared_error_derivative", samples, 160, [&]() {
+        for (std::size_t i = 0; i < samples; ++i) do_not_optimize(LossFunctions::mean_squared_error_derivative(predictions, targets));
+    });
+    suite.run("loss/categorical_cross_entropy", samples, 160, [&]() {
+        for (std::size_t i = 0; i < samples; ++i) do_not_optimize(LossFunctions::categorical_cross_entropy(predictions, targets));
+    });
+    suite.run("loss/categorical_cross_entropy_with_index", samples, 80, [&]() {
+        for (std::size_t i = 0; i < samples; ++i) do_not_optimize(LossFunctions::categorical_cross_entropy_with_index(predictions, 3));
+    });
+    suite.run("loss/categorical_cross_entropy_softmax_derivative", samples, 160, [&]() {
+        for (std::size_t i = 0; i < samples; ++i) do_not_optimize(LossFunctions::categorical_cross_entropy_softmax_derivative(predictions, targets));
+    });
+    suite.run("loss/categorical_cross_entropy_softmax_derivative_with_index", samples, 80, [&]() {
+        for (std::size_t i = 0; i < samples; ++i) do_not_optimize(LossFunctions::categorical_cross_entropy_softmax_derivative_with_index(predictions, 3));
+    });
+    std::vector<float> logits(samples * 10), grads(samples * 10);
+    std::vector<unsigned char> loss_labels(samples);
+    for (std::size_t i = 0; i < logits.size(); ++i) {
+        logits[i] = dist(rng);
+    }
+    for (std::size_t i = 0; i < samples; ++i) {
+        loss_labels[i] = static_cast<unsigned char>(i % 10);
+    }
+    suite.run("loss/softmax_cross_entropy<float> (batched)", samples, 80,
+              [&]() { do_not_optimize(LossFunctions::softmax_cross_entropy<float>(logits, loss_labels, grads, 10)); });
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        suite.write_json(out);
+        if (!out) {
+            throw std::runtime_error("Cannot write " + json_path);
+        }
+        std::printf("Wrote %s\n", json_path.c_str());
+    }
+}
+
+// Latency percentiles (in microseconds) of `iterations` timed calls of fn(i)
+template <typename Fn>
+void report_latency(const char* name, std::size_t iterations, Fn fn) {
+    std::vector<double> micros(iterations);
+    for (std::size_t i = 0; i < iterations / 10; ++i) {
+        fn(i); // Warm caches and branch predictors
+    }
+    for (std::size_t i = 0; i < iterations; ++i) {
+        Clock::time_point start = Clock::now();
+        fn(i);
+        micros[i] = seconds_since(start) * 1e6;
+    }
+    std::sort(micros.begin(), micros.end());
+    auto pct = [&](double p) { return micros[std::min(iterations - 1, static_cast<std::size_t>(p * iterations))]; };
+    std::printf("%-34s %9.2f %9.2f %9.2f %9.2f\n", name, pct(0.5), pct(0.9), pct(0.99), pct(0.999));
+}
+
+// Single-image latency of one topology: dynamic DenseLayer path vs StaticNetwork
+template <typename Static>
+void bench_latency_topology(const char* label, const NeuralNetwork& network, const std::vector<float>& images,
+                            std::size_t iterations) {
+    const std::size_t width = Static::input_size;
+    const std::size_t count = images.size() / width;
+    std::printf("%s\n", label);
+
+    Batch input(1, width);
+    PassBuffers buffers;
+    report_latency("  dynamic (NeuralNetwork::forward)", iterations, [&](std::size_t i) {
+        std::copy(images.begin() + (i % count) * width, images.begin() + (i % count + 1) * width, input.data());
+        do_not_optimize(network.forward(input, buffers).data()[0]);
+    });
+
+    std::unique_ptr<Static> fixed(new Static(network));
+    typename Static::OutputArray logits;
+    report_latency("  static  (StaticNetwork::forward)", iterations, [&](std::size_t i) {
+        fixed->forward(images.data() + (i % count) * width, logits.data());
+        do_not_optimize(logits[0]);
+    });
+}
+
+// --- Single-request scoring latency: p50/p90/p99/p99.9 per image ---
+// Usage: bench latency [model.ckpt]. The checkpoint must be 784-128-10 ReLU (what main saves);
+// without one a randomly initialized model of that shape is used.
+void bench_latency(int argc, char** argv) {
+    const char* model_path = (argc > 2) ? argv[2] : "mnist_model.ckpt";
+    const std::size_t iterations = 20000;
+
+    std::mt19937 rng(11);
+    std::vector<float> images(256 * 784);
+    for (float& p : images) {
+        p = (rng() % 5 == 0) ? static_cast<float>(rng() & 0xff) / 255.0f : 0.0f;
+    }
+
+    std::printf("%-34s %9s %9s %9s %9s   (us per image)\n", "", "p50", "p90", "p99", "p99.9");
+    NeuralNetwork small = file_exists(model_path) ? Checkpoint::load(model_path)
+                                                  : NeuralNetwork({784, 128, 10}, Activations::Kind::ReLU, 1);
+    bench_latency_topology<StaticNetwork<Activations::Kind::ReLU, 784, 128, 10>>("784-128-10 ReLU", small, images,
+                                                                                  iterations);
+    NeuralNetwork deep({784, 128, 64, 10}, Activations::Kind::ReLU, 1);
+    bench_latency_topology<StaticNetwork<Activations::Kind::ReLU, 784, 128, 64, 10>>("784-128-64-10 ReLU", deep,
+                                                                                      images, iterations);
+}
+
+// --- Steady-state allocation check: training steps must not call operator new ---
+// Usage: bench alloc-check. Counts allocations (via the profiler's operator new hook) over
+// 50 steps after warm-up, for 1 and 4 threads and a short final batch; exits non-zero
+// if any step allocated.
+bool bench_alloc_check() {
+#ifdef DNN_DISABLE_STATS
+    std::printf("alloc-check: allocation counting is compiled out (DNN_DISABLE_STATS)\n");
+    return true;
+#else
+    std::mt19937 rng(5);
+    Batch images(256, 784);
+    fill_random(images, rng);
+    std::vector<unsigned char> labels(256);
+    for (unsigned char& l : labels) {
+        l = static_cast<unsigned char>(rng() % 10);
+    }
+    Batch tail(100, 784);
+    std::copy(images.data(), images.data() + tail.size(), tail.data());
+    // The same rows thinned to MNIST-like density, for the sparse input path
+    SparseBatch sparse_images;
+    SparseBatch sparse_tail;
+    sparse_images.clear(784);
+    sparse_tail.clear(784);
+    for (std::size_t r = 0; r < images.rows(); ++r) {
+        for (std::size_t c = 0; c < 784; ++c) {
+            if (rng() % 5 == 0) {
+                sparse_images.push(static_cast<uint32_t>(c), images(r, c));
+            }
+        }
+        sparse_images.end_row();
+        if (r < tail.rows()) {
+            sparse_tail.append_row(sparse_images.row(r));
+        }
+    }
+
+    bool ok = true;
+    const std::size_t thread_counts[] = {1, 4};
+    for (int sparse = 0; sparse < 2; ++sparse) {
+        for (std::size_t threads : thread_counts) {
+            NeuralNetwork network({784, 128, 64, 10}, Activations::Kind::ReLU, 1);
+            SgdOptimizer optimizer(0.05f, 0.9f);
+            TrainerConfig config;
+            config.batch_size = 256;
+            config.num_threads = threads;
+            Trainer trainer(network, optimizer, config);
+
+            Span<const unsigned char> tail_labels(labels.data(), tail.rows());
+            auto step = [&](bool full, std::size_t* correct) {
+                if (sparse) {
+                    trainer.train_batch(full ? sparse_images : sparse_tail,
+                                        full ? Span<const unsigned char>(labels) : tail_labels, correct);
+                } else {
+                    trainer.train_batch(full ? images : tail,
+                                        full ? Span<const unsigned char>(labels) : tail_labels, correct);
+                }
+            };
+
+            // Warm-up: per-thread GEMM packing buffers and optimizer velocity are created lazily
+            step(true, nullptr);
+            step(false, nullptr);
+
+            Profiler::Snapshot begin = Profiler::snapshot();
+            std::size_t correct = 0;
+            for (int i = 0; i < 50; ++i) {
+                step(true, &correct);
+            }
+            step(false, &correct);
+            Profiler::Snapshot end = Profiler::snapshot();
+
+            uint64_t allocations = end.allocations - begin.allocations;
+            std::printf("alloc-check: %s input, %zu thread(s), 51 steps: %llu allocations (%llu bytes) %s\n",
+                        sparse ? "sparse" : "dense", threads,
+                        static_cast<unsigned long long>(allocations),
+                        static_cast<unsigned long long>(end.allocated_bytes - begin.allocated_bytes),
+                        allocations == 0 ? "OK" : "FAIL");
+            ok = ok && allocations == 0;
+        }
+    }
+    return ok;
+#endif
+}
+
+long peak_rss_kb() {
+    struct rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// --- Streaming loader: one training epoch over an IDX pair within a memory cap ---
+// Usage: bench stream [images.idx labels.idx] [--memory-mb N]
+// Without files it writes 250k synthetic images (~200 MB) to a temporary directory.
+void bench_stream(int argc, char** argv) {
+    std::string images_path;
+    std::string labels_path;
+    std::size_t memory_mb = 64;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--memory-mb") == 0 && i + 1 < argc) {
+            memory_mb = static_cast<std::size_t>(std::atoi(argv[++i]));
+        } else if (images_path.empty()) {
+            images_path = argv[i];
+        } else {
+            labels_path = argv[i];
+        }
+    }
+
+    std::unique_ptr<ScratchDir> fixtures;
+    if (labels_path.empty()) {
+        fixtures.reset(new ScratchDir());
+        images_path = fixtures->file("images-idx3-ubyte");
+        labels_path = fixtures->file("labels-idx1-ubyte");
+        write_synthetic_idx(images_path, labels_path, 250000);
+    }
+
+    const long rss_before = peak_rss_kb();
+    DataLoaderConfig loader_config;
+    loader_config.batch_size = 256;
+    loader_config.epochs = 1;
+    loader_config.memory_cap = memory_mb << 20;
+    DataLoader loader(images_path, labels_path, loader_config);
+
+    NeuralNetwork network({loader.image_size(), 128, 10}, Activations::Kind::ReLU, 1);
+    SgdOptimizer optimizer(0.05f, 0.9f);
+    TrainerConfig config;
+    config.batch_size = loader_config.batch_size;
+    Trainer trainer(network, optimizer, config);
+    EpochStats stats = trainer.train_epoch(loader);
+    const long rss_after = peak_rss_kb();
+
+    std::printf("Streaming loader: %zu images, memory cap %zu MiB, batch %zu\n", loader.count(), memory_mb,
+                loader_config.batch_size);
+    std::printf("  %.0f samples/s, loader wait %.1f ms (%zu stalls)\n", stats.samples_per_second,
+                stats.loader_wait_seconds * 1e3, stats.loader_stalls);
+    std::printf("  peak RSS %.1f MiB (+%.1f MiB while streaming)\n", rss_after / 1024.0,
+                (rss_after - rss_before) / 1024.0);
+}
+
+bool send_all(int fd, const unsigned char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+// Connected Unix socket, or -1
+int connect_unix(const std::string& path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+bool recv_all(int fd, unsigned char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t got = ::recv(fd, data, size, 0);
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        size -= static_cast<std::size_t>(got);
+    }
+    return true;
+}
+
+// --- Load generator for the inference server ---
+// Usage: bench loadgen [--socket path] [--clients N] [--requests M] [--max-batch B] [--max-wait-us W]
+// Each client connects and sends M synthetic 784-byte images closed-loop (next request after
+// the previous response), timing every round trip. Without --socket an in-process server
+// is started on a temporary socket, using mnist_model.ckpt if present or a random
+// 784-128-10 model, with the given batching settings.
+void bench_loadgen(int argc, char** argv) {
+    std::string socket_path;
+    std::size_t clients = 8;
+    std::size_t requests = 2000;
+    InferenceServerConfig server_config;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--socket") {
+            socket_path = argv[i + 1];
+        } else if (arg == "--clients") {
+            clients = static_cast<std::size_t>(std::atoi(argv[i + 1]));
+        } else if (arg == "--requests") {
+            requests = static_cast<std::size_t>(std::atoi(argv[i + 1]));
+        } else if (arg == "--max-batch") {
+            server_config.max_batch = static_cast<std::size_t>(std::atoi(argv[i + 1]));
+        } else if (arg == "--max-wait-us") {
+            server_config.max_wait_us = static_cast<std::size_t>(std::atoi(argv[i + 1]));
+        }
+    }
+
+    NeuralNetwork network;
+    std::unique_ptr<InferenceServer> server;
+    std::thread server_thread;
+    if (socket_path.empty()) {
+        network = file_exists("mnist_model.ckpt") ? Checkpoint::load("mnist_model.ckpt")
+                                                  : NeuralNetwork({784, 128, 10}, Activations::Kind::ReLU, 1);
+        socket_path = "/tmp/dnn_bench_" + std::to_string(::getpid()) + ".sock";
+        server_config.socket_path = socket_path;
+        server.reset(new InferenceServer(network, server_config));
+        server_thread = std::thread([&]() { server->run(); });
+        std::printf("In-process server: max batch %zu, max wait %zu us\n", server_config.max_batch,
+                    server_config.max_wait_us);
+    }
+
+    const std::size_t image_size = 784;
+    const std::size_t response_size = sizeof(uint32_t) + 10 * sizeof(float);
+    std::vector<std::vector<double>> latencies(clients);
+    std::vector<std::thread> threads;
+    std::vector<std::string> errors(clients);
+    Clock::time_point start = Clock::now();
+    for (std::size_t c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c]() {
+            int fd = connect_unix(socket_path);
+            if (fd < 0) {
+                errors[c] = "cannot connect to " + socket_path;
+                return;
+            }
+            std::mt19937 rng(static_cast<uint32_t>(c));
+            std::vector<unsigned char> image(image_size);
+            std::vector<unsigned char> response(response_size);
+            latencies[c].reserve(requests);
+            for (std::size_t r = 0; r < requests; ++r) {
+                for (unsigned char& p : image) {
+                    p = (rng() % 5 == 0) ? static_cast<unsigned char>(rng() & 0xff) : 0;
+                }
+                Clock::time_point sent = Clock::now();
+                if (!send_all(fd, image.data(), image.size()) || !recv_all(fd, response.data(), response.size())) {
+                    errors[c] = "connection closed by server";
+                    break;
+                }
+                latencies[c].push_back(seconds_since(sent) * 1e6);
+            }
+            ::close(fd);
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    const double seconds = seconds_since(start);
+
+    // A client that pipelines a burst well past the server's in-flight cap, then shuts down its
+    // write side, must still get every response, followed by EOF
+    const std::size_t burst = 4 * server_config.max_in_flight;
+    std::size_t answered = 0;
+    bool clean_eof = false;
+    int burst_fd = connect_unix(socket_path);
+    if (burst_fd >= 0) {
+        std::thread writer([&]() {
+            std::vector<unsigned char> image(image_size, 0);
+            for (std::size_t r = 0; r < burst && send_all(burst_fd, image.data(), image.size()); ++r) {
+            }
+            ::shutdown(burst_fd, SHUT_WR);
+        });
+        std::vector<unsigned char> response(response_size);
+        while (answered < burst && recv_all(burst_fd, response.data(), response.size())) {
+            ++answered;
+        }
+        unsigned char extra;
+        clean_eof = answered == burst && ::recv(burst_fd, &extra, 1, 0) == 0;
+        writer.join();
+        ::close(burst_fd);
+    }
+    std::printf("Half-closed client: %zu of %zu pipelined requests answered, %s\n", answered, burst,
+                clean_eof ? "then EOF" : "no clean EOF");
+
+    if (server) {
+        server->stop();
+        server_thread.join();
+        ServerStats stats = server->take_stats();
+        std::printf("Server side:  %zu requests in %zu batches (mean %.1f), latency p50 %.1f us, p99 %.1f us\n",
+                    stats.requests, stats.batches, stats.mean_batch, stats.p50_us, stats.p99_us);
+    }
+    for (const std::string& error : errors) {
+        if (!error.empty()) {
+            throw std::runtime_error("loadgen: " + error);
+        }
+    }
+    if (!clean_eof) {
+        throw std::runtime_error("loadgen: the half-closed client was not fully answered");
+    }
+
+    std::vector<double> all;
+    for (const std::vector<double>& l : latencies) {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all.empty() ? 0.0 : all[std::min(all.size() - 1, static_cast<std::size_t>(p * all.size()))]; };
+    std::printf("Client side:  %zu clients x %zu requests: %.0f req/s, round trip p50 %.1f us, p99 %.1f us, "
+                "p99.9 %.1f us\n",
+                clients, requests, all.size() / seconds, pct(0.5), pct(0.99), pct(0.999));
+}
+
+template <typename T>
+Tensor2D<T> convert_tensor(const Batch& src) {
+    Tensor2D<T> dst(src.rows(), src.cols());
+    std::copy(src.data(), src.data() + src.size(), dst.data());
+    return dst;
+}
+
+// One pass in fixed order, single-threaded, so float and double runs see identical batches.
+// Returns the mean seconds per step.
+template <typename T>
+double train_in_order(BasicNeuralNetwork<T>& network, const Tensor2D<T>& images,
+                      const std::vector<unsigned char>& labels, std::size_t batch_size) {
+    BasicSgdOptimizer<T> optimizer(0.05f, 0.9f);
+    BasicPassBuffers<T> buffers;
+    std::vector<BasicLayerGradients<T>> grads = network.make_gradients();
+    Tensor2D<T> batch;
+    std::size_t steps = 0;
+    Clock::time_point start = Clock::now();
+    for (std::size_t offset = 0; offset + batch_size <= images.rows(); offset += batch_size) {
+        batch.resize(batch_size, images.cols());
+        std::copy(images.data() + offset * images.cols(), images.data() + (offset + batch_size) * images.cols(),
+                  batch.data());
+        for (BasicLayerGradients<T>& g : grads) {
+            g.zero();
+        }
+        network.compute_gradients(batch, Span<const unsigned char>(labels.data() + offset, batch_size), T(1),
+                                  buffers, grads, nullptr);
+        optimizer.step(network, grads);
+        ++steps;
+    }
+    return steps > 0 ? seconds_since(start) / static_cast<double>(steps) : 0.0;
+}
+
+template <typename T>
+double accuracy_of(const BasicNeuralNetwork<T>& network, const Tensor2D<T>& images,
+                   const std::vector<unsigned char>& labels) {
+    BasicPassBuffers<T> buffers;
+    std::vector<unsigned char> predicted(images.rows());
+    argmax_rows(network.forward(images, buffers), Span<unsigned char>(predicted));
+    std::size_t correct = 0;
+    for (std::size_t i = 0; i < labels.size(); ++i) {
+        correct += (predicted[i] == labels[i]) ? 1 : 0;
+    }
+    return static_cast<double>(correct) / static_cast<double>(labels.size());
+}
+
+// Largest relative error between backprop and central-difference gradients over a sample of weights
+template <typename T>
+double gradient_check(const BasicNeuralNetwork<T>& reference, const Tensor2D<T>& input,
+                      const std::vector<unsigned char>& labels) {
+    BasicNeuralNetwork<T> network = reference;
+    BasicPassBuffers<T> buffers;
+    std::vector<BasicLayerGradients<T>> grads = network.make_gradients();
+    network.compute_gradients(input, labels, T(1), buffers, grads, nullptr);
+
+    std::vector<BasicLayerGradients<T>> scratch = network.make_gradients();
+    const T h = std::is_same<T, float>::value ? T(1e-2) : T(1e-6);
+    double worst = 0.0;
+    std::mt19937 rng(3);
+    for (std::size_t l = 0; l < network.num_layers(); ++l) {
+        Tensor2D<T>& w = network.layers()[l].weights();
+        for (int probe = 0; probe < 20; ++probe) {
+            std::size_t i = rng() % w.size();
+            const T saved = w.data()[i];
+            w.data()[i] = saved + h;
+            double up = network.compute_gradients(input, labels, T(1), buffers, scratch, nullptr);
+            w.data()[i] = saved - h;
+            double down = network.compute_gradients(input, labels, T(1), buffers, scratch, nullptr);
+            w.data()[i] = saved;
+            double numeric = (up - down) / (2.0 * static_cast<double>(h));
+            double analytic = static_cast<double>(grads[l].weights.data()[i]);
+            double scale = std::max(1e-6, std::fabs(numeric) + std::fabs(analytic));
+            worst = std::max(worst, std::fabs(numeric - analytic) / scale);
+        }
+    }
+    return worst;
+}
+
+template <typename T>
+std::size_t training_bytes(const BasicNeuralNetwork<T>& network, std::size_t batch_size) {
+    std::size_t params = 0;
+    std::size_t activations = 0;
+    for (const BasicDenseLayer<T>& layer : network.layers()) {
+        params += layer.weights().size() + layer.biases().size();
+        activations += 2 * batch_size * layer.outputs();
+    }
+    // Parameters, gradients, momentum, per-layer outputs and their gradients, the input batch
+    return (3 * params + activations + batch_size * network.input_size()) * sizeof(T);
+}
+
+// --- float vs double numeric path ---
+// Usage: bench precision [train-images train-labels test-images test-labels]
+// Gradient-checks both precisions, compares end-to-end step time and training memory, then
+// trains a float and a double copy of the same initial network for one epoch and compares
+// test accuracy. The step times reflect the GEMM each precision gets (Gemm::sgemm is packed
+// and SIMD, Gemm::dgemm a portable loop), not float against double arithmetic. Without
+// files it uses learnable synthetic digits. Exits non-zero if the two accuracies differ by
+// more than one percentage point.
+bool bench_precision(int argc, char** argv) {
+    Batch train_f;
+    Batch test_f;
+    std::vector<unsigned char> train_labels;
+    std::vector<unsigned char> test_labels;
+    if (argc >= 6) {
+        DataProcessor processor;
+        train_f = processor.process_images(MnistImageView(argv[2]));
+        train_labels = read_mnist_labels(argv[3]);
+        test_f = processor.process_images(MnistImageView(argv[4]));
+        test_labels = read_mnist_labels(argv[5]);
+    } else {
+        make_synthetic_digits(20000, 1, train_f, train_labels);
+        make_synthetic_digits(5000, 2, test_f, test_labels);
+    }
+    Tensor2D<double> train_d = convert_tensor<double>(train_f);
+    Tensor2D<double> test_d = convert_tensor<double>(test_f);
+
+    NeuralNetwork initial({784, 128, 10}, Activations::Kind::ReLU, 7);
+    BasicNeuralNetwork<double> initial_d(initial);
+
+    Batch probe_f(8, 784);
+    std::copy(train_f.data(), train_f.data() + probe_f.size(), probe_f.data());
+    Tensor2D<double> probe_d = convert_tensor<double>(probe_f);
+    std::vector<unsigned char> probe_labels(train_labels.begin(), train_labels.begin() + 8);
+    std::printf("Gradient check (max relative error, 20 weights per layer):\n");
+    std::printf("  float  %.3e\n  double %.3e\n", gradient_check(initial, probe_f, probe_labels),
+                gradient_check(initial_d, probe_d, probe_labels));
+
+    const std::size_t batch_size = 64;
+    NeuralNetwork net_f = initial;
+    BasicNeuralNetwork<double> net_d = initial_d;
+    double step_f = train_in_order(net_f, train_f, train_labels, batch_size);
+    double step_d = train_in_order(net_d, train_d, train_labels, batch_size);
+    double acc_f = accuracy_of(net_f, test_f, test_labels);
+    double acc_d = accuracy_of(net_d, test_d, test_labels);
+
+    std::printf("784-128-10 ReLU, batch %zu, one epoch over %zu images:\n", batch_size, train_f.rows());
+    std::printf("%8s %14s %16s %14s\n", "", "ms/step", "training MiB", "test acc");
+    std::printf("%8s %14.3f %16.2f %13.2f%%\n", "float", step_f * 1e3,
+                training_bytes(net_f, batch_size) / 1048576.0, acc_f * 100.0);
+    std::printf("%8s %14.3f %16.2f %13.2f%%\n", "double", step_d * 1e3,
+                training_bytes(net_d, batch_size) / 1048576.0, acc_d * 100.0);
+    // Not a precision-for-precision kernel comparison: float steps run the packed, register-blocked
+    // sgemm while double steps run the portable loop-ordered dgemm, so most of the ratio is kernel quality
+    std::printf("end-to-end step time, double / float: %.2fx (packed sgemm vs portable dgemm)\n",
+                step_d / step_f);
+    std::printf("accuracy difference %.2f points\n", std::fabs(acc_f - acc_d) * 100.0);
+
+    bool parity = std::fabs(acc_f - acc_d) <= 0.01;
+    std::printf("accuracy parity: %s\n", parity ? "OK" : "FAIL");
+    return parity;
+}
+
+// --- Fast transcendental approximations ---
+// Usage: bench approx
+// Sweeps every 61st float bit pattern across each function's documented domain, runs it
+// through the Precision::Fast kernels and compares with the double-precision reference
+// rounded to float, and checks that NaN inputs propagate. Then times Exact against Fast on
+// a 1 Mi-element array. Exits non-zero if any error exceeds the bounds stated in
+// activation_functions.h or a NaN is lost.
+uint32_t ordered_bits(float x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return (bits & 0x80000000u) ? 0x80000000u - (bits & 0x7FFFFFFFu) : bits + 0x80000000u;
+}
+
+double ulp_distance(float a, float b) {
+    uint32_t x = ordered_bits(a);
+    uint32_t y = ordered_bits(b);
+    return static_cast<double>(x > y ? x - y : y - x);
+}
+
+struct ApproxError {
+    double max_ulp = 0.0;
+    double max_abs = 0.0;
+    float worst_x = 0.0f;
+};
+
+// `ulp_from`: only inputs with |x| >= ulp_from count towards max_ulp (absolute error covers all)
+template <typename Kernel, typename Reference>
+ApproxError sweep_error(float lo, float hi, float ulp_from, Kernel kernel, Reference reference) {
+    const std::size_t chunk = 1 << 16;
+    std::vector<float> in;
+    std::vector<float> out(chunk);
+    in.reserve(chunk);
+    ApproxError error;
+    auto flush = [&]() {
+        kernel(ConstSpan<float>(in.data(), in.size()), Span<float>(out.data(), in.size()));
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            double exact = reference(static_cast<double>(in[i]));
+            double abs_err = std::fabs(static_cast<double>(out[i]) - exact);
+            error.max_abs = std::max(error.max_abs, abs_err);
+            if (std::fabs(in[i]) >= ulp_from) {
+                double ulp = ulp_distance(out[i], static_cast<float>(exact));
+                if (ulp > error.max_ulp) {
+                    error.max_ulp = ulp;
+                    error.worst_x = in[i];
+                }
+            }
+        }
+        in.clear();
+    };
+    // Walk the ordered bit patterns from lo to hi so every binade is sampled evenly
+    const uint32_t first = ordered_bits(lo);
+    const uint32_t last = ordered_bits(hi);
+    for (uint64_t key = first; key <= last; key += 61) {
+        uint32_t k = static_cast<uint32_t>(key);
+        uint32_t bits = (k & 0x80000000u) ? k - 0x80000000u : (0x80000000u - k) | 0x80000000u;
+        float x;
+        std::memcpy(&x, &bits, sizeof(x));
+        in.push_back(x);
+        if (in.size() == chunk) {
+            flush();
+        }
+    }
+    in.push_back(hi);
+    flush();
+    return error;
+}
+
+template <typename Kernel>
+double kernel_ns_per_element(Kernel kernel, const std::vector<float>& in, std::vector<float>& out) {
+    const int reps = 20;
+    kernel(ConstSpan<float>(in.data(), in.size()), Span<float>(out.data(), out.size()));
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < reps; ++r) {
+        kernel(ConstSpan<float>(in.data(), in.size()), Span<float>(out.data(), out.size()));
+    }
+    return seconds_since(start) * 1e9 / (static_cast<double>(reps) * in.size());
+}
+
+bool bench_approx() {
+    typedef void (*Kernel)(ConstSpan<float>, Span<float>);
+    struct Case {
+        const char* name;
+        Kernel kernel;
+        double (*reference)(double);
+        float lo;
+        float hi;
+        float ulp_from;
+        double ulp_bound;
+        double abs_bound; // 0: relative bound only
+    };
+    const Case cases[] = {
+        {"exp", &Activations::exponential<float>, [](double x) { return std::exp(x); }, -87.3f, 88.3f, 0.0f, 1.0, 0.0},
+        {"sigmoid", &Activations::sigmoid<float>, [](double x) { return 1.0 / (1.0 + std::exp(-x)); }, -87.3f,
+         87.3f, 0.0f, 2.0, 1e-7},
+        {"tanh", &Activations::tanh_activation<float>, [](double x) { return std::tanh(x); }, -20.0f, 20.0f, 1e-3f,
+         CpuFeatures::has_avx512f() ? 4.0 : 6.0, CpuFeatures::has_avx512f() ? 3e-7 : 4e-7},
+    };
+
+    Activations::Precision saved = Activations::precision();
+    Activations::set_precision(Activations::Precision::Fast);
+    bool ok = true;
+    std::printf("Fast-mode error vs double reference (every 61st float in range):\n");
+    std::printf("%8s %22s %10s %12s %14s %6s\n", "", "range", "max ULP", "at x", "max abs", "");
+    for (const Case& c : cases) {
+        ApproxError error = sweep_error(c.lo, c.hi, c.ulp_from, c.kernel, c.reference);
+        bool pass = error.max_ulp <= c.ulp_bound && (c.abs_bound == 0.0 || error.max_abs <= c.abs_bound);
+        ok = ok && pass;
+        char abs_text[32] = "-";
+        if (c.abs_bound > 0.0) {
+            std::snprintf(abs_text, sizeof(abs_text), "%.3e", error.max_abs);
+        }
+        std::printf("%8s   [%8.2f, %8.2f] %10.0f %12.5g %14s %6s\n", c.name, c.lo, c.hi, error.max_ulp,
+                    error.worst_x, abs_text, pass ? "OK" : "FAIL");
+    }
+
+    // NaN must come back as NaN, both in the vector body and in the scalar tail
+    std::vector<float> nan_in(37, 0.5f);
+    std::vector<float> nan_out(nan_in.size());
+    for (std::size_t i = 0; i < nan_in.size(); i += 3) {
+        nan_in[i] = std::numeric_limits<float>::quiet_NaN();
+    }
+    for (const Case& c : cases) {
+        c.kernel(ConstSpan<float>(nan_in.data(), nan_in.size()), Span<float>(nan_out.data(), nan_out.size()));
+        bool pass = true;
+        for (std::size_t i = 0; i < nan_in.size(); ++i) {
+            pass = pass && (std::isnan(nan_out[i]) == std::isnan(nan_in[i]));
+        }
+        ok = ok && pass;
+        std::printf("%8s   NaN in -> NaN out %40s\n", c.name, pass ? "OK" : "FAIL");
+    }
+
+    std::vector<float> in(1 << 20);
+    std::vector<float> out(in.size());
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+    for (float& v : in) {
+        v = dist(rng);
+    }
+    std::printf("Throughput over %zu floats in [-10, 10]:\n", in.size());
+    std::printf("%8s %14s %14s %10s\n", "", "exact ns/elem", "fast ns/elem", "speedup");
+    for (const Case& c : cases) {
+        Activations::set_precision(Activations::Precision::Exact);
+        double exact = kernel_ns_per_element(c.kernel, in, out);
+        Activations::set_precision(Activations::Precision::Fast);
+        double fast = kernel_ns_per_element(c.kernel, in, out);
+        std::printf("%8s %14.3f %14.3f %9.2fx\n", c.name, exact, fast, exact / fast);
+    }
+    Activations::set_precision(saved);
+
+    std::printf("error bounds: %s\n", ok ? "OK" : "FAIL");
+    return ok;
+}
+
+// --- Sparse vs dense input layer ---
+// Usage: bench sparse [images.idx labels.idx]
+// Defaults to the MNIST training set main.cpp reads, falling back to synthetic images with
+// MNIST's ~19% nonzero pixels. Checks that the sparse 784-128 input layer matches the dense
+// one, times forward + weight gradient for both across input densities (the crossover
+// is what Sparse::kMaxDensity encodes), then trains one epoch through a dense and a sparse
+// DataLoader. Exits non-zero if the sparse results deviate from the dense ones.
+double input_layer_step_seconds(const DenseLayer& layer, const Batch* dense, const SparseBatch* sparse,
+                                Batch& output, LayerGradients& grads) {
+    const int reps = 50;
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < reps; ++r) {
+        if (sparse != nullptr) {
+            layer.forward(*sparse, output);
+            layer.backward(*sparse, output, output, grads); // Gradient value is irrelevant for timing
+        } else {
+            layer.forward(*dense, output);
+            layer.backward(*dense, output, output, nullptr, grads);
+        }
+    }
+    return seconds_since(start) / reps;
+}
+
+double max_abs_difference(const Batch& a, const Batch& b) {
+    double diff = 0.0;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        diff = std::max(diff, static_cast<double>(std::fabs(a.data()[i] - b.data()[i])));
+    }
+    return diff;
+}
+
+bool bench_sparse(int argc, char** argv) {
+    std::string images_path = (argc >= 4) ? argv[2] : "../data/train-images-idx3-ubyte/train-images-idx3-ubyte";
+    std::string labels_path = (argc >= 4) ? argv[3] : "../data/train-labels-idx1-ubyte/train-labels-idx1-ubyte";
+    std::unique_ptr<ScratchDir> scratch;
+    if (!file_exists(images_path.c_str()) || !file_exists(labels_path.c_str())) {
+        scratch.reset(new ScratchDir());
+        images_path = scratch->file("images-idx3-ubyte");
+        labels_path = scratch->file("labels-idx1-ubyte");
+        std::printf("No training set found; using 60000 synthetic images\n");
+        write_synthetic_idx(images_path, labels_path, 60000);
+    }
+    MnistImageView view(images_path);
+    std::vector<unsigned char> labels = read_mnist_labels(labels_path);
+    const std::size_t width = view.image_size();
+    const std::size_t batch_size = 64;
+
+    DataProcessor processor;
+    SparseBatch all;
+    processor.process_images_sparse(view.pixels(), width, all);
+    std::printf("%zu images, %.1f%% nonzero pixels\n", all.rows(), all.density() * 100.0);
+
+    // Parity on the first batch: outputs and every gradient
+    DenseLayer layer(width, 128, Activations::Kind::ReLU, 3);
+    Batch dense;
+    processor.process_images_into(view.pixels().subspan(0, batch_size * width), width, dense);
+    SparseBatch sparse;
+    processor.process_images_sparse(view.pixels().subspan(0, batch_size * width), width, sparse);
+    Batch out_dense;
+    Batch out_sparse;
+    layer.forward(dense, out_dense);
+    layer.forward(sparse, out_sparse);
+    double forward_diff = max_abs_difference(out_dense, out_sparse);
+    Batch upstream(batch_size, 128);
+    std::mt19937 rng(5);
+    fill_random(upstream, rng);
+    Batch dz_dense = upstream;
+    Batch dz_sparse = upstream;
+    LayerGradients grads_dense(width, 128);
+    LayerGradients grads_sparse(width, 128);
+    layer.backward(dense, out_dense, dz_dense, nullptr, grads_dense);
+    layer.backward(sparse, out_sparse, dz_sparse, grads_sparse);
+    double weight_diff = max_abs_difference(grads_dense.weights, grads_sparse.weights);
+    double bias_diff = max_abs_difference(grads_dense.biases, grads_sparse.biases);
+    bool parity = forward_diff < 1e-4 && weight_diff < 1e-4 && bias_diff < 1e-4;
+    std::printf("Sparse vs dense max |diff|: output %.2e, dW %.2e, db %.2e: %s\n", forward_diff, weight_diff,
+                bias_diff, parity ? "OK" : "FAIL");
+
+    // Layer timing by density: the data's own first batch, then uniform random pixels
+    // thinned to each target density
+    std::printf("784-128 ReLU input layer, batch %zu, forward + dW:\n", batch_size);
+    std::printf("%10s %12s %12s %10s\n", "density", "dense us", "sparse us", "speedup");
+    auto report = [&](const char* label, const Batch& x) {
+        SparseBatch xs;
+        xs.clear(width);
+        for (std::size_t r = 0; r < x.rows(); ++r) {
+            xs.append_dense_row(x.data() + r * width);
+        }
+        Batch out;
+        LayerGradients grads(width, 128);
+        double dense_s = input_layer_step_seconds(layer, &x, nullptr, out, grads);
+        double sparse_s = input_layer_step_seconds(layer, nullptr, &xs, out, grads);
+        char name[32];
+        std::snprintf(name, sizeof(name), "%s%.2f", label, xs.density());
+        std::printf("%10s %12.1f %12.1f %9.2fx\n", name, dense_s * 1e6, sparse_s * 1e6, dense_s / sparse_s);
+    };
+    report("data ", dense);
+    const double densities[] = {0.05, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.8, 1.0};
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (double density : densities) {
+        Batch x(batch_size, width);
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            float keep = unit(rng);
+            x.data()[i] = (keep < density) ? std::max(unit(rng), 1e-3f) : 0.0f;
+        }
+        report("", x);
+    }
+    std::printf("dense fallback above density %.2f\n", Sparse::kMaxDensity);
+
+    // One epoch end to end (single thread, same seed and order)
+    std::printf("One training epoch, 784-128-10 ReLU, batch %zu, 1 thread:\n", batch_size);
+    std::printf("%8s %14s %12s %12s\n", "input", "samples/s", "loss", "train acc");
+    double accuracy[2] = {0.0, 0.0};
+    for (int mode = 0; mode < 2; ++mode) {
+        NeuralNetwork network({width, 128, 10}, Activations::Kind::ReLU, 1);
+        SgdOptimizer optimizer(0.05f, 0.9f);
+        TrainerConfig trainer_config;
+        trainer_config.batch_size = batch_size;
+        trainer_config.num_threads = 1;
+        Trainer trainer(network, optimizer, trainer_config);
+        DataLoaderConfig loader_config;
+        loader_config.batch_size = batch_size;
+        loader_config.epochs = 1;
+        loader_config.sparse = (mode == 1);
+        DataLoader loader(view, labels, loader_config);
+        EpochStats stats = trainer.train_epoch(loader);
+        accuracy[mode] = stats.accuracy;
+        std::printf("%8s %14.0f %12.4f %11.2f%%\n", mode == 1 ? "sparse" : "dense", stats.samples_per_second,
+                    stats.mean_loss, stats.accuracy * 100.0);
+    }
+    bool same_training = std::fabs(accuracy[0] - accuracy[1]) <= 0.005;
+    std::printf("training parity: %s\n", same_training ? "OK" : "FAIL");
+    return parity && same_training;
+}
+
+// --- Preprocessed dataset cache ---
+// Usage: bench cache [images.idx labels.idx] [--cache path]
+// Times startup (open + first batch ready) from the IDX files, a cache rebuild and a
+// warm cache open, checks the cached rows against DataProcessor's output, and checks
+// that touching a source file invalidates the cache. Exits non-zero on a mismatch.
+bool bench_cache(int argc, char** argv) {
+    std::string images_path = "../data/train-images-idx3-ubyte/train-images-idx3-ubyte";
+    std::string labels_path = "../data/train-labels-idx1-ubyte/train-labels-idx1-ubyte";
+    ScratchDir scratch; // Synthetic sources and the default cache
+    std::string cache_path = scratch.file("cache.bin");
+    std::vector<std::string> positional;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cache" && i + 1 < argc) {
+            cache_path = argv[++i];
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() >= 2) {
+        images_path = positional[0];
+        labels_path = positional[1];
+    } else if (!file_exists(images_path.c_str()) || !file_exists(labels_path.c_str())) {
+        images_path = scratch.file("images-idx3-ubyte");
+        labels_path = scratch.file("labels-idx1-ubyte");
+        std::printf("No training set found; using 60000 synthetic images\n");
+        write_synthetic_idx(images_path, labels_path, 60000);
+    }
+
+    DataLoaderConfig loader_config;
+    loader_config.batch_size = 64;
+    loader_config.epochs = 1;
+    auto first_batch = [](DataLoader& loader) {
+        const LoaderBatch* batch = loader.next();
+        if (batch == nullptr) {
+            throw std::runtime_error("bench cache: the loader produced no batch.");
+        }
+        loader.release(batch);
+    };
+
+    std::printf("Startup to first batch, %s:\n", images_path.c_str());
+    Clock::time_point start = Clock::now();
+    {
+        MnistImageView view(images_path);
+        std::vector<unsigned char> labels = read_mnist_labels(labels_path);
+        DataProcessor processor;
+        Batch images = processor.process_images(view);
+    }
+    std::printf("  %-34s %9.1f ms\n", "IDX parse + process_images", seconds_since(start) * 1e3);
+
+    start = Clock::now();
+    {
+        MnistImageView view(images_path);
+        std::vector<unsigned char> labels = read_mnist_labels(labels_path);
+        DataLoader loader(view, labels, loader_config);
+        first_batch(loader);
+    }
+    std::printf("  %-34s %9.1f ms\n", "IDX mapped + loader", seconds_since(start) * 1e3);
+
+    std::remove(cache_path.c_str());
+    start = Clock::now();
+    bool rebuilt = DatasetCache(cache_path, images_path, labels_path).rebuilt();
+    std::printf("  %-34s %9.1f ms\n", "cache rebuild", seconds_since(start) * 1e3);
+
+    start = Clock::now();
+    std::unique_ptr<DatasetCache> cache(new DatasetCache(cache_path, images_path, labels_path));
+    {
+        DataLoader loader(*cache, loader_config);
+        first_batch(loader);
+    }
+    std::printf("  %-34s %9.1f ms\n", "cache open + loader", seconds_since(start) * 1e3);
+    bool ok = rebuilt && !cache->rebuilt();
+
+    // Contents: every row as DataProcessor normalizes it, labels byte for byte
+    MnistImageView view(images_path);
+    std::vector<unsigned char> labels = read_mnist_labels(labels_path);
+    std::vector<float> row(view.image_size());
+    bool same = cache->count() == view.count() && cache->image_size() == view.image_size();
+    for (std::size_t i = 0; same && i < view.count(); ++i) {
+        DataProcessor::normalize_pixels(view.image(i).data(), row.data(), row.size());
+        same = std::memcmp(row.data(), cache->image(i), row.size() * sizeof(float)) == 0 &&
+               cache->labels()[i] == labels[i];
+    }
+    std::printf("cached contents: %s\n", same ? "OK" : "FAIL");
+    ok = ok && same;
+
+    // Staleness on a small scratch pair (the real files are left untouched)
+    const std::string scratch_images = scratch.file("staleness-images");
+    const std::string scratch_labels = scratch.file("staleness-labels");
+    const std::string scratch_cache = scratch.file("staleness-cache");
+    write_synthetic_idx(scratch_images, scratch_labels, 100);
+    std::remove(scratch_cache.c_str());
+    bool first = DatasetCache(scratch_cache, scratch_images, scratch_labels).rebuilt();
+    bool second = DatasetCache(scratch_cache, scratch_images, scratch_labels).rebuilt();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    write_synthetic_idx(scratch_images, scratch_labels, 100); // Same bytes, new mtime
+    bool third = DatasetCache(scratch_cache, scratch_images, scratch_labels).rebuilt();
+    bool stale_ok = first && !second && third;
+    std::printf("rebuild on first use / reuse / after touching the source: %s/%s/%s: %s\n", first ? "yes" : "no",
+                second ? "yes" : "no", third ? "yes" : "no", stale_ok ? "OK" : "FAIL");
+    return ok && stale_ok;
+}
+
+// --- On-the-fly augmentation ---
+// Usage: bench augment [images.idx labels.idx] [--threads N]
+// Checks that an identity configuration reproduces the input, that a sample's distortion
+// is the same whatever pool size produced it and changes between epochs, then times the
+// augmenter alone across pool sizes and one training epoch over raw and augmented
+// batches. Exits non-zero if a check fails.
+bool bench_augment(int argc, char** argv) {
+    std::string images_path = "../data/train-images-idx3-ubyte/train-images-idx3-ubyte";
+    std::string labels_path = "../data/train-labels-idx1-ubyte/train-labels-idx1-ubyte";
+    std::size_t max_threads = 4;
+    std::vector<std::string> positional;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            max_threads = std::max<std::size_t>(std::stoull(argv[++i]), 1);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    std::unique_ptr<ScratchDir> fixtures;
+    if (positional.size() >= 2) {
+        images_path = positional[0];
+        labels_path = positional[1];
+    } else if (!file_exists(images_path.c_str()) || !file_exists(labels_path.c_str())) {
+        fixtures.reset(new ScratchDir());
+        images_path = fixtures->file("images-idx3-ubyte");
+        labels_path = fixtures->file("labels-idx1-ubyte");
+        std::printf("No training set found; using 60000 synthetic images\n");
+        write_synthetic_idx(images_path, labels_path, 60000);
+    }
+    MnistImageView view(images_path);
+    std::vector<unsigned char> labels = read_mnist_labels(labels_path);
+    const std::size_t width = view.image_size();
+    const std::size_t n = std::min<std::size_t>(view.count(), 10000);
+    std::vector<const unsigned char*> sources(n);
+    std::vector<std::size_t> samples(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        sources[i] = view.image(i).data();
+        samples[i] = i;
+    }
+
+    AugmentConfig identity;
+    identity.max_rotation_degrees = 0.0f;
+    identity.min_scale = 1.0f;
+    identity.max_scale = 1.0f;
+    identity.max_shift = 0.0f;
+    identity.elastic_alpha = 0.0f;
+    Augmenter unchanged(view.rows(), view.cols(), identity);
+    Augmenter::Scratch scratch = unchanged.make_scratch();
+    std::vector<unsigned char> out(n * width);
+    bool identity_ok = true;
+    for (std::size_t i = 0; identity_ok && i < n; ++i) {
+        unchanged.augment(sources[i], out.data(), 0, i, scratch);
+        identity_ok = std::memcmp(out.data(), sources[i], width) == 0;
+    }
+    std::printf("identity transform reproduces the input: %s\n", identity_ok ? "OK" : "FAIL");
+
+    Augmenter augmenter(view.rows(), view.cols(), AugmentConfig());
+    std::vector<unsigned char> reference(n * width);
+    std::vector<unsigned char> next_epoch(n * width);
+    std::printf("Augmenting %zu images (%s sampling):\n", n, CpuFeatures::has_avx2() ? "AVX2" : "scalar");
+    std::printf("%8s %14s %10s\n", "threads", "images/s", "same");
+    bool deterministic = true;
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        ThreadPool pool(threads);
+        std::vector<Augmenter::Scratch> scratches;
+        for (std::size_t t = 0; t < pool.size(); ++t) {
+            scratches.push_back(augmenter.make_scratch());
+        }
+        std::vector<unsigned char>& target = threads == 1 ? reference : out;
+        Clock::time_point start = Clock::now();
+        augmenter.augment_batch(sources.data(), samples.data(), n, 0, target.data(), pool, scratches);
+        double seconds = seconds_since(start);
+        bool same = target == reference;
+        deterministic = deterministic && same;
+        std::printf("%8zu %14.0f %10s\n", threads, static_cast<double>(n) / seconds, same ? "yes" : "NO");
+        if (threads == 1) {
+            augmenter.augment_batch(sources.data(), samples.data(), n, 1, next_epoch.data(), pool, scratches);
+        }
+    }
+    std::size_t redrawn = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        redrawn += std::memcmp(reference.data() + i * width, next_epoch.data() + i * width, width) != 0;
+    }
+    bool varies = redrawn * 100 >= n * 99;
+    std::printf("same across pool sizes: %s; redrawn next epoch: %zu/%zu: %s\n", deterministic ? "OK" : "FAIL",
+                redrawn, n, varies ? "OK" : "FAIL");
+    // Resampling smears pixels into their neighbours, which the sparse input layer pays for
+    std::size_t raw_nonzero = 0;
+    std::size_t augmented_nonzero = 0;
+    for (std::size_t i = 0; i < n * width; ++i) {
+        raw_nonzero += sources[i / width][i % width] != 0;
+        augmented_nonzero += reference[i] != 0;
+    }
+    std::printf("nonzero pixels: raw %.1f%%, augmented %.1f%%\n", 100.0 * raw_nonzero / (n * width),
+                100.0 * augmented_nonzero / (n * width));
+
+    // One epoch as main.cpp trains it (sparse batches), raw vs augmented
+    std::printf("One training epoch, 784-128-10 ReLU, batch 64, 1 trainer thread:\n");
+    std::printf("%-22s %10s %14s %12s %12s\n", "input", "seconds", "samples/s", "loss", "loader wait");
+    double raw_seconds = 0.0;
+    for (std::size_t augment_threads = 0; augment_threads <= std::min<std::size_t>(max_threads, 2); ++augment_threads) {
+        NeuralNetwork network({width, 128, 10}, Activations::Kind::ReLU, 1);
+        SgdOptimizer optimizer(0.05f, 0.9f);
+        TrainerConfig trainer_config;
+        trainer_config.batch_size = 64;
+        trainer_config.num_threads = 1;
+        Trainer trainer(network, optimizer, trainer_config);
+        DataLoaderConfig loader_config;
+        loader_config.batch_size = 64;
+        loader_config.epochs = 1;
+        loader_config.sparse = true;
+        loader_config.augment = augment_threads > 0;
+        loader_config.augment_threads = augment_threads;
+        DataLoader loader(view, labels, loader_config);
+        EpochStats stats = trainer.train_epoch(loader);
+        if (augment_threads == 0) {
+            raw_seconds = stats.seconds;
+        }
+        std::string name = augment_threads == 0 ? "raw" : "augmented, " + std::to_string(augment_threads) + " thread(s)";
+        std::printf("%-22s %10.2f %14.0f %12.4f %11.3fs\n", name.c_str(), stats.seconds, stats.samples_per_second,
+                    stats.mean_loss, stats.loader_wait_seconds);
+        if (augment_threads > 0) {
+            std::printf("%-22s %10.2fx raw epoch time\n", "", stats.seconds / raw_seconds);
+        }
+    }
+    return identity_ok && deterministic && varies;
+}
+
+// --- Test-set evaluation ---
+// Usage: bench eval [model.ckpt images.idx labels.idx] [--threads N]
+// Defaults to the model main.cpp saves and the t10k files; without them it scores a random
+// 784-128-10 network on synthetic images. Times a serial per-image loop against
+// Evaluator for dense and sparse batches across thread counts. Exits non-zero if any
+// run's confusion matrix differs from the single-thread one or its accuracy or loss
+// drifts from the serial loop.
+bool bench_eval(int argc, char** argv) {
+    std::string model_path = "mnist_model.ckpt";
+    std::string images_path = "../data/t10k-images-idx3-ubyte/t10k-images-idx3-ubyte";
+    std::string labels_path = "../data/t10k-labels-idx1-ubyte/t10k-labels-idx1-ubyte";
+    std::size_t max_threads = 4;
+    std::vector<std::string> positional;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            max_threads = std::max<std::size_t>(std::stoull(argv[++i]), 1);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() >= 3) {
+        model_path = positional[0];
+        images_path = positional[1];
+        labels_path = positional[2];
+    }
+    NeuralNetwork network;
+    if (file_exists(model_path.c_str())) {
+        network = Checkpoint::load(model_path);
+    } else {
+        network = NeuralNetwork({784, 128, 10}, Activations::Kind::ReLU, 1);
+        model_path = "random 784-128-10 network";
+    }
+    std::unique_ptr<ScratchDir> fixtures;
+    if (!file_exists(images_path.c_str()) || !file_exists(labels_path.c_str())) {
+        fixtures.reset(new ScratchDir());
+        images_path = fixtures->file("images-idx3-ubyte");
+        labels_path = fixtures->file("labels-idx1-ubyte");
+        write_synthetic_idx(images_path, labels_path, 10000);
+    }
+    MnistImageView images(images_path);
+    std::vector<unsigned char> labels = read_mnist_labels(labels_path);
+    std::printf("Evaluating %s on %zu images from %s\n", model_path.c_str(), images.count(), images_path.c_str());
+
+    // What evaluation looked like before: one image at a time through the dense path
+    const std::size_t width = images.image_size();
+    const std::size_t classes = network.output_size();
+    Batch input(1, width);
+    Tensor2D<float> probabilities(1, classes);
+    std::vector<double> row(classes);
+    PassBuffers buffers;
+    std::size_t serial_correct = 0;
+    double serial_loss = 0.0;
+    Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < images.count(); ++i) {
+        DataProcessor::normalize_pixels(images.image(i).data(), input.data(), width);
+        const Tensor2D<float>& logits = network.forward(input, buffers);
+        Activations::softmax<float>(logits.flat(), probabilities.flat(), classes);
+        std::copy(probabilities.data(), probabilities.data() + classes, row.begin());
+        serial_loss += LossFunctions::categorical_cross_entropy_with_index(row, labels[i]);
+        serial_correct += static_cast<std::size_t>(std::max_element(logits.data(), logits.data() + classes) - logits.data()) == labels[i];
+    }
+    double serial_seconds = seconds_since(start);
+    const double serial_accuracy = static_cast<double>(serial_correct) / static_cast<double>(images.count());
+    serial_loss /= static_cast<double>(images.count());
+
+    std::printf("%-8s %8s %12s %10s %10s %8s\n", "input", "threads", "images/s", "accuracy", "loss", "check");
+    std::printf("%-8s %8d %12.0f %9.2f%% %10.4f %8s\n", "serial", 1, images.count() / serial_seconds,
+                serial_accuracy * 100.0, serial_loss, "-");
+    bool ok = true;
+    for (int sparse = 0; sparse < 2; ++sparse) {
+        std::vector<std::size_t> reference;
+        for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+            EvaluatorConfig config;
+            config.num_threads = threads;
+            config.sparse = sparse == 1;
+            Evaluator evaluator(network, config);
+            evaluator.evaluate(images, labels); // Warm-up
+            EvalStats stats = evaluator.evaluate(images, labels);
+            if (threads == 1) {
+                reference = stats.confusion;
+            }
+            // Batched GEMMs may round differently from the one-row serial pass, so compare
+            // with the serial loop within a tolerance and across thread counts exactly
+            bool same = stats.confusion == reference && std::fabs(stats.accuracy - serial_accuracy) <= 0.001 &&
+                        std::fabs(stats.mean_loss - serial_loss) <= 1e-4 * std::max(1.0, serial_loss);
+            ok = ok && same;
+            std::printf("%-8s %8zu %12.0f %9.2f%% %10.4f %8s\n", sparse ? "sparse" : "dense", threads,
+                        stats.images_per_second, stats.accuracy * 100.0, stats.mean_loss, same ? "OK" : "FAIL");
+        }
+    }
+    return ok;
+}
+
+void usage() {
+    std::printf("usage: bench [modules [--json out.json] [--reps N]\n"
+                "             | gemm\n"
+                "             | train-scaling [images.idx labels.idx]\n"
+                "             | int8 [model.ckpt images.idx labels.idx]\n"
+                "             | stream [images.idx labels.idx] [--memory-mb N]\n"
+                "             | latency [model.ckpt]\n"
+                "             | alloc-check\n"
+                "             | precision [train-images train-labels test-images test-labels]\n"
+                "             | approx\n"
+                "             | sparse [images.idx labels.idx]\n"
+                "             | cache [images.idx labels.idx] [--cache path]\n"
+                "             | augment [images.idx labels.idx] [--threads N]\n"
+                "             | eval [model.ckpt images.idx labels.idx] [--threads N]\n"
+                "             | loadgen [--socket path] [--clients N] [--requests M] [--max-batch B] [--max-wait-us W]]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        std::string suite = (argc > 1) ? argv[1] : "modules";
+        if (suite == "modules") {
+            bench_modules(argc, argv);
+        } else if (suite == "gemm") {
+            bench_gemm();
+        } else if (suite == "train-scaling") {
+            bench_train_scaling(argc, argv);
+        } else if (suite == "int8") {
+            bench_int8(argc, argv);
+        } else if (suite == "stream") {
+            bench_stream(argc, argv);
+        } else if (suite == "latency") {
+            bench_latency(argc, argv);
+        } else if (suite == "alloc-check") {
+            return bench_alloc_check() ? 0 : 1;
+        } else if (suite == "precision") {
+            return bench_precision(argc, argv) ? 0 : 1;
+        } else if (suite == "approx") {
+            return bench_approx() ? 0 : 1;
+        } else if (suite == "sparse") {
+            return bench_sparse(argc, argv) ? 0 : 1;
+        } else if (suite == "cache") {
+            return bench_cache(argc, argv) ? 0 : 1;
+        } else if (suite == "augment") {
+            return bench_augment(argc, argv) ? 0 : 1;
+        } else if (suite == "eval") {
+            return bench_eval(argc, argv) ? 0 : 1;
+        } else if (suite == "loadgen") {
+            bench_loadgen(argc, argv);
+        } else {
+            usage();
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from discarding a benchmarked result
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct BenchResult {
+    std::string name;
+    std::size_t reps = 0;
+    double ops_per_rep = 0.0;
+    double bytes_per_op = 0.0;
+    double mean_ns = 0.0;   // Per operation
+    double stddev_ns = 0.0; // Per operation, across repetitions
+    double min_ns = 0.0;    // Per operation
+
+    double ops_per_second() const { return mean_ns > 0.0 ? 1e9 / mean_ns : 0.0; }
+    double mb_per_second() const { return bytes_per_op * ops_per_second() / 1e6; }
+};
+
+// Times callables over several repetitions and reports per-op statistics.
+// Each call of fn performs `ops` operations (e.g. one call over 1M elements = 1M ops),
+// so tiny ops are timed in bulk instead of against clock resolution.
+class BenchSuite {
+public:
+    BenchSuite(const std::string& name, std::size_t reps) : name_(name), reps_(std::max<std::size_t>(reps, 2)) {}
+
+    template <typename Fn>
+    const BenchResult& run(const std::string& name, double ops, double bytes_per_op, Fn fn) {
+        fn(); // Warm-up: page faults, lazily initialized buffers, CPU dispatch
+
+        std::vector<double> samples(reps_);
+        for (std::size_t r = 0; r < reps_; ++r) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            fn();
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            samples[r] = std::chrono::duration<double, std::nano>(end - start).count() / ops;
+        }
+
+        BenchResult result;
+        result.name = name;
+        result.reps = reps_;
+        result.ops_per_rep = ops;
+        result.bytes_per_op = bytes_per_op;
+        double sum = 0.0;
+        for (double s : samples) {
+            sum += s;
+        }
+        result.mean_ns = sum / samples.size();
+        double var = 0.0;
+        for (double s : samples) {
+            var += (s - result.mean_ns) * (s - result.mean_ns);
+        }
+        result.stddev_ns = std::sqrt(var / (samples.size() - 1));
+        result.min_ns = *std::min_element(samples.begin(), samples.end());
+
+        std::printf("%-62s %12.3f ns/op  +-%5.1f%%  %14.0f op/s", name.c_str(), result.mean_ns,
+                    result.mean_ns > 0.0 ? 100.0 * result.stddev_ns / result.mean_ns : 0.0,
+                    result.ops_per_second());
+        if (bytes_per_op > 0.0) {
+            std::printf("  %10.1f MB/s", result.mb_per_second());
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+
+        results_.push_back(result);
+        return results_.back();
+    }
+
+    // {"suite": ..., "reps": ..., "results": [{...}, ...]}
+    void write_json(std::ostream& out) const {
+        char buf[512];
+        out << "{\n  \"suite\": \"" << name_ << "\",\n  \"reps\": " << reps_ << ",\n  \"results\": [\n";
+        for (std::size_t i = 0; i < results_.size(); ++i) {
+            const BenchResult& r = results_[i];
+            std::snprintf(buf, sizeof(buf),
+                          "    {\"name\": \"%s\", \"ops_per_rep\": %.0f, \"mean_ns\": %.4f, \"stddev_ns\": %.4f, "
+                          "\"min_ns\": %.4f, \"ops_per_sec\": %.1f, \"mb_per_sec\": %.2f}%s\n",
+                          r.name.c_str(), r.ops_per_rep, r.mean_ns, r.stddev_ns, r.min_ns, r.ops_per_second(),
+                          r.mb_per_second(), (i + 1 < results_.size()) ? "," : "");
+            out << buf;
+        }
+        out << "  ]\n}\n";
+    }
+
+private:
+    std::string name_;
+    std::size_t reps_;
+    std::vector<BenchResult> results_;
+};
+
+#endif // BENCH_HARNESS_H
@@ -0,0 +1,254 @@
+#include "checkpoint.h"
+#include "atomic_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace {
+
+const char kMagic[8] = {'D', 'N', 'N', 'M', 'O', 'D', 'E', 'L'};
+const std::size_t kHeaderSize = 64;
+const std::size_t kLayerRecordSize = 32;
+const std::size_t kBlobAlignment = 64;
+
+const uint64_t kFnvOffset = 1469598103934665603ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t fnv1a(uint64_t hash, const unsigned char* data, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        hash ^= data[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+bool host_is_little_endian() {
+    const uint32_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+std::size_t align_up(std::size_t n) {
+    return (n + kBlobAlignment - 1) / kBlobAlignment * kBlobAlignment;
+}
+
+void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+void put_u64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+uint32_t get_u32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+uint64_t get_u64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// Streams bytes to a FILE*, hashing everything written after the header
+class BlobWriter {
+public:
+    BlobWriter(std::FILE* file, const std::string& path) : file_(file), path_(path), hash_(kFnvOffset), pos_(0) {}
+
+    void write(const void* data, std::size_t n) {
+        if (n > 0 && std::fwrite(data, 1, n, file_) != n) {
+            throw std::runtime_error("Checkpoint: write failed: " + path_);
+        }
+        hash_ = fnv1a(hash_, static_cast<const unsigned char*>(data), n);
+        pos_ += n;
+    }
+
+    // Zero-pads up to the next blob boundary
+    void pad() {
+        static const unsigned char zeros[kBlobAlignment] = {};
+        write(zeros, align_up(pos_) - pos_);
+    }
+
+    void write_floats(const float* values, std::size_t count) {
+        if (host_is_little_endian()) {
+            write(values, count * sizeof(float));
+            return;
+        }
+        unsigned char bytes[4];
+        for (std::size_t i = 0; i < count; ++i) {
+            uint32_t bits;
+            std::memcpy(&bits, &values[i], 4);
+            put_u32(bytes, bits);
+            write(bytes, 4);
+        }
+    }
+
+    uint64_t hash() const { return hash_; }
+    std::size_t pos() const { return pos_; }
+
+private:
+    std::FILE* file_;
+    std::string path_;
+    uint64_t hash_;
+    std::size_t pos_;
+};
+
+void write_file(const NeuralNetwork& network, std::FILE* file, const std::string& path) {
+    const std::vector<DenseLayer>& layers = network.layers();
+
+    // Lay out the blobs first so the layer table can be written up front
+    std::size_t cursor = align_up(kHeaderSize + layers.size() * kLayerRecordSize);
+    std::vector<unsigned char> table(layers.size() * kLayerRecordSize, 0);
+    for (std::size_t i = 0; i < layers.size(); ++i) {
+        unsigned char* record = table.data() + i * kLayerRecordSize;
+        put_u32(record + 0, static_cast<uint32_t>(layers[i].inputs()));
+        put_u32(record + 4, static_cast<uint32_t>(layers[i].outputs()));
+        put_u32(record + 8, static_cast<uint32_t>(layers[i].activation()));
+        put_u64(record + 16, cursor);
+        cursor += align_up(layers[i].weights().size() * sizeof(float));
+        put_u64(record + 24, cursor);
+        cursor += align_up(layers[i].biases().size() * sizeof(float));
+    }
+    const std::size_t file_size = cursor;
+
+    // Header placeholder; rewritten once the checksum is known
+    unsigned char header[kHeaderSize] = {};
+    if (std::fwrite(header, 1, kHeaderSize, file) != kHeaderSize) {
+        throw std::runtime_error("Checkpoint: write failed: " + path);
+    }
+
+    BlobWriter writer(file, path);
+    writer.write(table.data(), table.size());
+    writer.pad();
+    for (const DenseLayer& layer : layers) {
+        writer.write_floats(layer.weights().data(), layer.weights().size());
+        writer.pad();
+        writer.write_floats(layer.biases().data(), layer.biases().size());
+        writer.pad();
+    }
+    if (kHeaderSize + writer.pos() != file_size) {
+        throw std::logic_error("Checkpoint: layout mismatch while writing " + path);
+    }
+
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    put_u32(header + 8, Checkpoint::kVersion);
+    put_u32(header + 12, static_cast<uint32_t>(Checkpoint::DType::Float32));
+    put_u32(header + 16, static_cast<uint32_t>(layers.size()));
+    put_u64(header + 24, file_size);
+    put_u64(header + 32, writer.hash());
+    if (std::fseek(file, 0, SEEK_SET) != 0 || std::fwrite(header, 1, kHeaderSize, file) != kHeaderSize) {
+        throw std::runtime_error("Checkpoint: write failed: " + path);
+    }
+}
+
+// True if count floats starting at offset lie inside a file of size bytes, without overflow
+bool blob_fits(uint64_t offset, uint64_t count, std::size_t size) {
+    uint64_t bytes;
+    return offset <= size && !__builtin_mul_overflow(count, sizeof(float), &bytes) && bytes <= size - offset;
+}
+
+} // namespace
+
+namespace Checkpoint {
+
+    void save(const NeuralNetwork& network, const std::string& path) {
+        if (network.num_layers() == 0) {
+            throw std::invalid_argument("Checkpoint::save: network has no layers.");
+        }
+        write_file_atomically(path, [&](std::FILE* file, const std::string& tmp_path) {
+            write_file(network, file, tmp_path);
+        });
+    }
+
+    NeuralNetwork load(const std::string& path) {
+        CheckpointView view(path, true);
+        NeuralNetwork network;
+        for (std::size_t i = 0; i < view.num_layers(); ++i) {
+            const CheckpointView::Layer& src = view.layer(i);
+            network.layers().emplace_back(src.inputs, src.outputs, src.activation, 0);
+            DenseLayer& dst = network.layers().back();
+            std::copy(src.weights, src.weights + src.inputs * src.outputs, dst.weights().data());
+            std::copy(src.biases, src.biases + src.outputs, dst.biases().data());
+        }
+        return network;
+    }
+
+} // namespace Checkpoint
+
+CheckpointView::CheckpointView(const std::string& path, bool verify_checksum) : file_(path) {
+    if (!host_is_little_endian()) {
+        throw std::runtime_error("CheckpointView: in-place weights require a little-endian host.");
+    }
+    const unsigned char* base = file_.data();
+    if (file_.size() < kHeaderSize || std::memcmp(base, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Invalid checkpoint file: incorrect magic number: " + path);
+    }
+    if (get_u32(base + 8) != Checkpoint::kVersion) {
+        throw std::runtime_error("Invalid checkpoint file: unsupported version: " + path);
+    }
+    if (get_u32(base + 12) != static_cast<uint32_t>(Checkpoint::DType::Float32)) {
+        throw std::runtime_error("Invalid checkpoint file: unsupported dtype: " + path);
+    }
+    std::size_t num_layers = get_u32(base + 16);
+    if (get_u64(base + 24) != file_.size() || num_layers == 0 ||
+        kHeaderSize + num_layers * kLayerRecordSize > file_.size()) {
+        throw std::runtime_error("Invalid checkpoint file: truncated or corrupt header: " + path);
+    }
+    if (verify_checksum &&
+        fnv1a(kFnvOffset, base + kHeaderSize, file_.size() - kHeaderSize) != get_u64(base + 32)) {
+        throw std::runtime_error("Invalid checkpoint file: checksum mismatch: " + path);
+    }
+
+    layers_.resize(num_layers);
+    for (std::size_t i = 0; i < num_layers; ++i) {
+        const unsigned char* record = base + kHeaderSize + i * kLayerRecordSize;
+        Layer& layer = layers_[i];
+        layer.inputs = get_u32(record + 0);
+        layer.outputs = get_u32(record + 4);
+        uint32_t activation = get_u32(record + 8);
+        if (activation > static_cast<uint32_t>(Activations::Kind::Tanh)) {
+            throw std::runtime_error("Invalid checkpoint file: unknown activation: " + path);
+        }
+        layer.activation = static_cast<Activations::Kind>(activation);
+
+        uint64_t weights_offset = get_u64(record + 16);
+        uint64_t biases_offset = get_u64(record + 24);
+        const uint64_t weight_count = static_cast<uint64_t>(layer.inputs) * layer.outputs; // Two u32s
+        if (weights_offset % kBlobAlignment != 0 || biases_offset % kBlobAlignment != 0 ||
+            !blob_fits(weights_offset, weight_count, file_.size()) ||
+            !blob_fits(biases_offset, layer.outputs, file_.size())) {
+            throw std::runtime_error("Invalid checkpoint file: bad blob offset: " + path);
+        }
+        if (i > 0 && layer.inputs != layers_[i - 1].outputs) {
+            throw std::runtime_error("Invalid checkpoint file: layer shapes do not chain: " + path);
+        }
+        layer.weights = reinterpret_cast<const float*>(base + weights_offset);
+        layer.biases = reinterpret_cast<const float*>(base + biases_offset);
+    }
+}
+
+const Tensor2D<float>& CheckpointView::forward(const Tensor2D<float>& input, PassBuffers& buffers) const {
+    buffers.outputs.resize(layers_.size());
+    const Tensor2D<float>* x = &input;
+    for (std::size_t i = 0; i < layers_.size(); ++i) {
+        const Layer& layer = layers_[i];
+        dense_forward(layer.weights, layer.biases, layer.inputs, layer.outputs, layer.activation, *x,
+                      buffers.outputs[i]);
+        x = &buffers.outputs[i];
+    }
+    return *x;
+}
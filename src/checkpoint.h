@@ -0,0 +1,74 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "activation_functions.h"
+#include "mapped_file.h"
+#include "neural_network.h"
+#include "tensor.h"
+
+// Binary model checkpoint, version 1. All integers and floats are little-endian.
+//
+//   offset 0   CheckpointHeader (64 bytes)
+//   offset 64  num_layers x CheckpointLayerRecord (32 bytes each)
+//   ...        weight and bias blobs, each starting on a 64-byte boundary
+//
+// The checksum is FNV-1a 64 over every byte after the header. Because blobs are
+// aligned and stored in the in-memory layout (row-major inputs x outputs), a mapped
+// checkpoint can be used for inference directly, without parsing or copying.
+namespace Checkpoint {
+
+    const uint32_t kVersion = 1;
+
+    enum class DType : uint32_t {
+        Float32 = 0
+    };
+
+    /**
+     * @brief Writes network to path atomically.
+     * Layers are streamed one blob at a time through write_file_atomically, so readers see
+     * either the old file or the complete new one, and the rename survives a crash.
+     * Throws std::runtime_error on I/O failure.
+     */
+    void save(const NeuralNetwork& network, const std::string& path);
+
+    // Reads a checkpoint into a trainable network (copies the weights, verifying the checksum)
+    NeuralNetwork load(const std::string& path);
+
+} // namespace Checkpoint
+
+// Read-only, zero-copy view of a checkpoint file for inference.
+// Layer weights point straight into the mapping.
+class CheckpointView {
+public:
+    struct Layer {
+        std::size_t inputs;
+        std::size_t outputs;
+        Activations::Kind activation;
+        const float* weights; // inputs x outputs
+        const float* biases;  // outputs
+    };
+
+    // Maps the file and validates the header and layer table. verify_checksum = true also
+    // hashes every blob, which touches each page of the mapping; it is off by default so a
+    // server can map a large model without reading it all up front.
+    explicit CheckpointView(const std::string& path, bool verify_checksum = false);
+
+    std::size_t num_layers() const { return layers_.size(); }
+    const Layer& layer(std::size_t i) const { return layers_[i]; }
+    std::size_t input_size() const { return layers_.front().inputs; }
+    std::size_t output_size() const { return layers_.back().outputs; }
+
+    // Forward pass straight from the mapped weights; returns logits stored in buffers
+    const Tensor2D<float>& forward(const Tensor2D<float>& input, PassBuffers& buffers) const;
+
+private:
+    MappedFile file_;
+    std::vector<Layer> layers_;
+};
+
+#endif // CHECKPOINT_H
@@ -1,2 +1,8 @@
-clang++ -std=c++11 -Wall -o mnist_app main.cpp mnist_reader.cpp data_processor.cpp
-./mnist_app
\ No newline at end of file
+CXX=${CXX:-clang++}
+# Add -DDNN_DISABLE_STATS for a release build without profiling counters or allocation tracking
+CXXFLAGS="-std=c++17 -O2 -Wall -pthread"
+SOURCES="mnist_reader.cpp mapped_file.cpp atomic_file.cpp cpu_features.cpp data_processor.cpp activation_functions.cpp loss_functions.cpp gemm.cpp layer.cpp neural_network.cpp optimizer.cpp thread_pool.cpp trainer.cpp data_loader.cpp checkpoint.cpp quantized_network.cpp profiler.cpp workspace.cpp sparse_batch.cpp dataset_cache.cpp augmentation.cpp evaluator.cpp"
+$CXX $CXXFLAGS -o mnist_app main.cpp $SOURCES
+$CXX $CXXFLAGS -o bench bench.cpp inference_server.cpp $SOURCES
+$CXX $CXXFLAGS -o mnist_server server.cpp inference_server.cpp $SOURCES
+./mnist_app
@@ -0,0 +1,47 @@
+#include "cpu_features.h"
+
+namespace CpuFeatures {
+
+#if DNN_X86
+    namespace {
+        struct Features {
+            bool sse2;
+            bool avx2;
+            bool fma;
+            bool avx512f;
+            bool avx512bw;
+            bool avx512vnni;
+
+            Features() {
+                __builtin_cpu_init();
+                sse2 = __builtin_cpu_supports("sse2");
+                avx2 = __builtin_cpu_supports("avx2");
+                fma = __builtin_cpu_supports("fma");
+                avx512f = __builtin_cpu_supports("avx512f");
+                avx512bw = __builtin_cpu_supports("avx512bw");
+                avx512vnni = __builtin_cpu_supports("avx512vnni");
+            }
+        };
+
+        const Features& features() {
+            static const Features f;
+            return f;
+        }
+    } // namespace
+
+    bool has_sse2() { return features().sse2; }
+    bool has_avx2() { return features().avx2; }
+    bool has_fma() { return features().fma; }
+    bool has_avx512f() { return features().avx512f; }
+    bool has_avx512bw() { return features().avx512bw; }
+    bool has_avx512vnni() { return features().avx512vnni; }
+#else
+    bool has_sse2() { return false; }
+    bool has_avx2() { return false; }
+    bool has_fma() { return false; }
+    bool has_avx512f() { return false; }
+    bool has_avx512bw() { return false; }
+    bool has_avx512vnni() { return false; }
+#endif
+
+} // namespace CpuFeatures
@@ -0,0 +1,27 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// Runtime CPU feature detection used to pick SIMD kernels.
+// Results are queried once and cached; all functions return false on non-x86 builds.
+namespace CpuFeatures {
+
+    bool has_sse2();
+    bool has_avx2();
+    bool has_fma();
+    bool has_avx512f();
+    bool has_avx512bw();
+    bool has_avx512vnni();
+
+} // namespace CpuFeatures
+
+// Marks a function as compiled for an instruction set beyond the baseline.
+// Only call such functions after the matching CpuFeatures check succeeds.
+#if defined(__x86_64__) || defined(__i386__)
+#define DNN_X86 1
+#define DNN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DNN_X86 0
+#define DNN_TARGET(isa)
+#endif
+
+#endif // CPU_FEATURES_H
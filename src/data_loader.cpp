@@ -0,0 +1,289 @@
+#include "data_loader.h"
+#include "data_processor.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+const std::size_t kDefaultMemoryCap = std::size_t(256) << 20;
+
+} // namespace
+
+DataLoader::DataLoader(const MnistImageView& images, Span<const unsigned char> labels, const DataLoaderConfig& config)
+    : images_(&images), cache_(nullptr), labels_(labels), config_(config),
+      ready_(std::max<std::size_t>(config.prefetch, 1) + 1), free_(std::max<std::size_t>(config.prefetch, 1)),
+      stopping_(false), finished_(false) {
+    if (labels.size() != images.count()) {
+        throw std::invalid_argument("DataLoader: image and label counts differ.");
+    }
+    if (config_.batch_size == 0) {
+        throw std::invalid_argument("DataLoader: batch_size must be non-zero.");
+    }
+    init_slots(images.image_size(), images.rows(), images.cols());
+}
+
+DataLoader::DataLoader(const DatasetCache& cache, const DataLoaderConfig& config)
+    : images_(nullptr), cache_(&cache), labels_(cache.labels()), config_(config),
+      ready_(std::max<std::size_t>(config.prefetch, 1) + 1), free_(std::max<std::size_t>(config.prefetch, 1)),
+      stopping_(false), finished_(false) {
+    if (config_.batch_size == 0) {
+        throw std::invalid_argument("DataLoader: batch_size must be non-zero.");
+    }
+    if (config_.augment) {
+        throw std::invalid_argument("DataLoader: augmentation needs raw pixels; a dataset cache holds normalized rows.");
+    }
+    init_slots(cache.image_size(), cache.rows(), cache.cols());
+}
+
+DataLoader::DataLoader(const std::string& images_path, const std::string& labels_path, const DataLoaderConfig& config)
+    : images_(nullptr), cache_(nullptr), config_(config),
+      ready_(std::max<std::size_t>(config.prefetch, 1) + 1), free_(std::max<std::size_t>(config.prefetch, 1)),
+      stopping_(false), finished_(false) {
+    if (config_.batch_size == 0) {
+        throw std::invalid_argument("DataLoader: batch_size must be non-zero.");
+    }
+    // Open once with a single-batch chunk to learn the image size, then size the real chunk
+    stream_.reset(new MnistChunkStream(images_path, labels_path, config_.batch_size));
+    const std::size_t width = stream_->image_size();
+    const std::size_t prefetch = std::max<std::size_t>(config_.prefetch, 1);
+    const std::size_t cap = config_.memory_cap != 0 ? config_.memory_cap : kDefaultMemoryCap;
+
+    // Each batch slot holds batch_size float rows plus labels (sparse slots reserve room for
+    // every pixel plus its index, and augmentation stages one batch of u8 rows); each chunk
+    // sample costs its pixels, its label and one shuffle index
+    const std::size_t pixel_bytes = config_.sparse ? sizeof(float) + sizeof(uint32_t) : sizeof(float);
+    const std::size_t slot_bytes = prefetch * config_.batch_size * (width * pixel_bytes + 1) +
+                                   (config_.augment ? config_.batch_size * width : 0);
+    const std::size_t sample_bytes = width + 1 + sizeof(uint32_t);
+    if (cap < slot_bytes + config_.batch_size * sample_bytes) {
+        throw std::invalid_argument("DataLoader: memory_cap of " + std::to_string(cap) +
+                                    " bytes cannot hold the batch slots and one batch-sized chunk.");
+    }
+    // Whole batches per chunk, so only the final chunk of an epoch yields a short batch
+    std::size_t chunk = (cap - slot_bytes) / sample_bytes / config_.batch_size * config_.batch_size;
+    if (chunk > config_.batch_size) {
+        stream_.reset(new MnistChunkStream(images_path, labels_path, chunk));
+    }
+    init_slots(width, stream_->rows(), stream_->cols());
+}
+
+void DataLoader::init_slots(std::size_t image_size, std::size_t rows, std::size_t cols) {
+    config_.prefetch = std::max<std::size_t>(config_.prefetch, 1);
+    if (config_.augment) {
+        augmenter_.reset(new Augmenter(rows, cols, config_.augmentation));
+        augment_pool_.reset(new ThreadPool(std::max<std::size_t>(config_.augment_threads, 1)));
+        for (std::size_t t = 0; t < augment_pool_->size(); ++t) {
+            augment_scratch_.push_back(augmenter_->make_scratch());
+        }
+        augment_sources_.resize(config_.batch_size);
+        augment_samples_.resize(config_.batch_size);
+        augmented_.resize(config_.batch_size * image_size);
+    }
+
+    slots_.resize(config_.prefetch);
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+        if (config_.sparse) {
+            // Worst case of all pixels nonzero, so filling a slot never allocates
+            slots_[i].images.resize(0, image_size);
+            slots_[i].sparse.clear(image_size);
+            slots_[i].sparse.reserve(config_.batch_size, config_.batch_size * image_size);
+        } else {
+            slots_[i].images.resize(config_.batch_size, image_size);
+        }
+        slots_[i].labels.reserve(config_.batch_size);
+        free_.try_push(i);
+    }
+    thread_ = std::thread(&DataLoader::producer_loop, this);
+}
+
+DataLoader::~DataLoader() {
+    stopping_.store(true, std::memory_order_release);
+    ready_signal_.notify();
+    free_signal_.notify();
+    thread_.join();
+}
+
+std::size_t DataLoader::count() const {
+    if (cache_ != nullptr) {
+        return cache_->count();
+    }
+    return stream_ ? stream_->count() : images_->count();
+}
+
+std::size_t DataLoader::batches_per_epoch() const {
+    return (count() + config_.batch_size - 1) / config_.batch_size;
+}
+
+bool DataLoader::push_ready(std::size_t slot) {
+    bool pushed = false;
+    ready_signal_.wait([&]() {
+        pushed = ready_.try_push(slot);
+        return pushed || stopping_.load(std::memory_order_acquire);
+    });
+    if (pushed) {
+        ready_signal_.notify();
+    }
+    return pushed;
+}
+
+void DataLoader::fill(LoaderBatch& batch, const unsigned char* pixels, Span<const unsigned char> labels,
+                      const uint32_t* order, std::size_t rows, std::size_t first_sample, std::size_t epoch) {
+    DNN_PROFILE_SCOPE(Profiler::Phase::Process);
+    const std::size_t width = batch.images.cols();
+    batch.labels.resize(rows);
+    for (std::size_t r = 0; r < rows; ++r) {
+        batch.labels[r] = labels[order[r]];
+    }
+    if (augmenter_) {
+        for (std::size_t r = 0; r < rows; ++r) {
+            augment_sources_[r] = pixels + order[r] * width;
+            augment_samples_[r] = first_sample + order[r];
+        }
+        augmenter_->augment_batch(augment_sources_.data(), augment_samples_.data(), rows, epoch, augmented_.data(),
+                                  *augment_pool_, augment_scratch_);
+    }
+    const unsigned char* augmented = augmented_.data();
+    auto row = [&](std::size_t r) {
+        return augmenter_ ? augmented + r * width : pixels + order[r] * width;
+    };
+    if (config_.sparse) {
+        batch.sparse.clear(width);
+        for (std::size_t r = 0; r < rows; ++r) {
+            DataProcessor::append_sparse_pixels(row(r), width, batch.sparse);
+        }
+        return;
+    }
+    batch.images.resize(rows, width);
+    for (std::size_t r = 0; r < rows; ++r) {
+        DataProcessor::normalize_pixels(row(r), batch.images.data() + r * width, width);
+    }
+}
+
+void DataLoader::fill(LoaderBatch& batch, const float* pixels, Span<const unsigned char> labels,
+                      const uint32_t* order, std::size_t rows, std::size_t, std::size_t) const {
+    const std::size_t width = batch.images.cols();
+    batch.labels.resize(rows);
+    for (std::size_t r = 0; r < rows; ++r) {
+        batch.labels[r] = labels[order[r]];
+    }
+    if (config_.sparse) {
+        batch.sparse.clear(width);
+        for (std::size_t r = 0; r < rows; ++r) {
+            batch.sparse.append_dense_row(pixels + order[r] * width);
+        }
+        return;
+    }
+    batch.images.resize(rows, width);
+    for (std::size_t r = 0; r < rows; ++r) {
+        const float* src = pixels + order[r] * width;
+        std::copy(src, src + width, batch.images.data() + r * width);
+    }
+}
+
+template <typename Pixel>
+bool DataLoader::produce(const Pixel* pixels, Span<const unsigned char> labels,
+                         const std::vector<uint32_t>& order, std::size_t first_sample, std::size_t epoch) {
+    for (std::size_t offset = 0; offset < order.size(); offset += config_.batch_size) {
+        std::size_t slot;
+        bool popped = false;
+        free_signal_.wait([&]() {
+            popped = free_.try_pop(slot);
+            return popped || stopping_.load(std::memory_order_acquire);
+        });
+        if (!popped) {
+            return false;
+        }
+        LoaderBatch& batch = slots_[slot];
+        fill(batch, pixels, labels, order.data() + offset, std::min(config_.batch_size, order.size() - offset),
+             first_sample, epoch);
+        batch.epoch = epoch;
+        if (!push_ready(slot)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DataLoader::producer_loop() {
+    try {
+        std::vector<uint32_t> order(stream_ ? stream_->chunk_images() : count());
+        for (std::size_t epoch = 0; config_.epochs == 0 || epoch < config_.epochs; ++epoch) {
+            std::mt19937 rng(config_.seed + static_cast<uint32_t>(epoch));
+            if (stream_) {
+                stream_->rewind();
+                MnistChunk chunk;
+                while (stream_->next(chunk)) {
+                    order.resize(chunk.count);
+                    std::iota(order.begin(), order.end(), 0u);
+                    std::shuffle(order.begin(), order.end(), rng);
+                    if (!produce(chunk.pixels.data(), chunk.labels, order, chunk.first, epoch)) {
+                        return;
+                    }
+                }
+            } else {
+                std::iota(order.begin(), order.end(), 0u);
+                std::shuffle(order.begin(), order.end(), rng);
+                bool more = cache_ != nullptr ? produce(cache_->images(), labels_, order, 0, epoch)
+                                              : produce(images_->pixels().data(), labels_, order, 0, epoch);
+                if (!more) {
+                    return;
+                }
+            }
+            if (!push_ready(kEndOfEpoch)) {
+                return;
+            }
+        }
+    } catch (...) {
+        error_ = std::current_exception();
+        push_ready(kEndOfEpoch);
+    }
+    finished_.store(true, std::memory_order_release);
+    ready_signal_.notify();
+}
+
+const LoaderBatch* DataLoader::next() {
+    std::size_t slot;
+    if (!ready_.try_pop(slot)) {
+        DNN_PROFILE_SCOPE(Profiler::Phase::LoaderWait);
+        ++stats_.stalls;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool popped = false;
+        ready_signal_.wait([&]() {
+            popped = ready_.try_pop(slot);
+            return popped || finished_.load(std::memory_order_acquire);
+        });
+        // Re-check the ring after seeing the flag: the final marker may have landed in between
+        bool exhausted = !popped && !ready_.try_pop(slot);
+        stats_.wait_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (exhausted) {
+            return nullptr;
+        }
+    }
+    ready_signal_.notify(); // The loader may be waiting for room in ready_
+    if (slot == kEndOfEpoch) {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return nullptr;
+    }
+    ++stats_.batches;
+    return &slots_[slot];
+}
+
+void DataLoader::release(const LoaderBatch* batch) {
+    std::size_t slot = static_cast<std::size_t>(batch - slots_.data());
+    // free_ has room for every slot, so this cannot fail
+    free_.try_push(slot);
+    free_signal_.notify();
+}
+
+LoaderStats DataLoader::take_stats() {
+    LoaderStats stats = stats_;
+    stats_ = LoaderStats();
+    return stats;
+}
@@ -0,0 +1,146 @@
+#ifndef DATA_LOADER_H
+#define DATA_LOADER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "augmentation.h"
+#include "dataset_cache.h"
+#include "mnist_reader.h"
+#include "sparse_batch.h"
+#include "span.h"
+#include "spsc_ring.h"
+#include "tensor.h"
+#include "thread_pool.h"
+
+struct DataLoaderConfig {
+    std::size_t batch_size = 64;
+    std::size_t prefetch = 4; // Batches prepared ahead of the consumer (>= 2 for double buffering)
+    uint32_t seed = 1;        // Epoch e is shuffled with seed + e
+    std::size_t epochs = 0;   // 0 = keep producing epochs until the loader is destroyed
+    // Streaming loaders only: upper bound on the bytes the loader allocates (batch slots plus
+    // the read chunk). 0 = 256 MiB.
+    std::size_t memory_cap = 0;
+    // Emit batches in CSR form (LoaderBatch::sparse) for the sparse input-layer kernel
+    bool sparse = false;
+    // Distort every sample with a fresh random affine + elastic transform (see Augmenter)
+    // before normalization. Raw-pixel modes only: the cache holds already-normalized rows.
+    bool augment = false;
+    AugmentConfig augmentation;
+    std::size_t augment_threads = 1; // Loader-side pool that shares the augmentation work
+};
+
+// A prepared mini-batch. Owned by the loader; valid until passed back to release().
+struct LoaderBatch {
+    Batch images;                      // rows x image_size, normalized to [0, 1]; empty in sparse mode
+    SparseBatch sparse;                // The same rows, nonzero pixels only; sparse mode only
+    std::vector<unsigned char> labels; // rows
+    std::size_t epoch = 0;
+};
+
+// Per-epoch input pipeline metrics, seen from the consumer
+struct LoaderStats {
+    std::size_t batches = 0;
+    std::size_t stalls = 0;      // next() calls that found no batch ready
+    double wait_seconds = 0.0;   // Total time next() spent waiting for a batch
+};
+
+// Asynchronous mini-batch producer.
+// A background thread shuffles the sample order each epoch, gathers the raw u8 pixels
+// of each batch from the mapped file straight into a preallocated float buffer
+// (normalizing on the way), and hands the buffer to the consumer through a lock-free
+// SPSC ring. Used buffers come back through a second ring, so no memory is allocated
+// after construction and batch N+1 is prepared while batch N trains. A side that finds
+// its ring empty (or full) sleeps on a RingSignal rather than spinning.
+//
+// With config.augment set, the gathered u8 rows are first distorted by a pool of
+// augment_threads threads (the loader thread is one of them) into a staging buffer.
+// Distortions are seeded per (epoch, sample), so the batches do not depend on the
+// thread count.
+//
+// The DatasetCache constructor reads already-normalized rows from a mapped cache file,
+// so batches are plain row copies.
+//
+// The path-based constructor streams instead of mapping: the dataset is read sequentially
+// in chunks sized to fit config.memory_cap, and each chunk is shuffled on its own. Sample
+// order is therefore only mixed within a chunk, which is the price of training on files
+// larger than RAM.
+class DataLoader {
+public:
+    // images and labels must outlive the loader
+    DataLoader(const MnistImageView& images, Span<const unsigned char> labels, const DataLoaderConfig& config);
+    // cache must outlive the loader
+    DataLoader(const DatasetCache& cache, const DataLoaderConfig& config);
+    // Streams the IDX pair through a MnistChunkStream. Throws std::invalid_argument if the
+    // memory cap cannot hold the batch slots plus one chunk of a single batch.
+    DataLoader(const std::string& images_path, const std::string& labels_path, const DataLoaderConfig& config);
+    ~DataLoader();
+
+    DataLoader(const DataLoader&) = delete;
+    DataLoader& operator=(const DataLoader&) = delete;
+
+    std::size_t batches_per_epoch() const;
+    // Samples per epoch
+    std::size_t count() const;
+    std::size_t image_size() const { return slots_.front().images.cols(); }
+    bool sparse() const { return config_.sparse; }
+
+    // Next batch of the current epoch, or nullptr once the epoch is exhausted
+    // (the following call starts the next epoch). After the last configured epoch it keeps
+    // returning nullptr. Rethrows errors from the loader thread.
+    const LoaderBatch* next();
+
+    // Returns a batch from next() to the loader for reuse
+    void release(const LoaderBatch* batch);
+
+    // Metrics since the previous call (or construction), then resets them
+    LoaderStats take_stats();
+
+private:
+    static const std::size_t kEndOfEpoch = static_cast<std::size_t>(-1);
+
+    void init_slots(std::size_t image_size, std::size_t rows, std::size_t cols);
+    void producer_loop();
+    // Fills and publishes one batch per batch_size entries of order. False if stopping.
+    // Pixel is unsigned char (raw IDX pixels) or float (normalized cache rows). Entry i of
+    // order is dataset sample first_sample + order[i].
+    template <typename Pixel>
+    bool produce(const Pixel* pixels, Span<const unsigned char> labels, const std::vector<uint32_t>& order,
+                 std::size_t first_sample, std::size_t epoch);
+    void fill(LoaderBatch& batch, const unsigned char* pixels, Span<const unsigned char> labels,
+              const uint32_t* order, std::size_t rows, std::size_t first_sample, std::size_t epoch);
+    void fill(LoaderBatch& batch, const float* pixels, Span<const unsigned char> labels,
+              const uint32_t* order, std::size_t rows, std::size_t first_sample, std::size_t epoch) const;
+    bool push_ready(std::size_t slot);
+
+    const MnistImageView* images_;            // Mapped mode
+    const DatasetCache* cache_;               // Cache mode
+    Span<const unsigned char> labels_;        // Mapped and cache modes
+    std::unique_ptr<MnistChunkStream> stream_; // Streaming mode
+    DataLoaderConfig config_;
+    std::vector<LoaderBatch> slots_;
+    SpscRing<std::size_t> ready_; // loader -> consumer (slot index or kEndOfEpoch)
+    SpscRing<std::size_t> free_;  // consumer -> loader
+    RingSignal ready_signal_;     // Pushes to and pops from ready_, finished_
+    RingSignal free_signal_;      // Pushes to free_, stopping_
+    std::atomic<bool> stopping_;
+    std::atomic<bool> finished_;  // Loader thread has pushed everything it ever will
+    std::exception_ptr error_;    // Set by the loader thread before it pushes its final marker
+    LoaderStats stats_;
+    // Augmentation, used only by the loader thread
+    std::unique_ptr<Augmenter> augmenter_;
+    std::unique_ptr<ThreadPool> augment_pool_;
+    std::vector<Augmenter::Scratch> augment_scratch_;
+    std::vector<const unsigned char*> augment_sources_;
+    std::vector<std::size_t> augment_samples_;
+    std::vector<unsigned char> augmented_; // batch_size distorted rows
+    std::thread thread_;
+};
+
+#endif // DATA_LOADER_H
@@ -1,9 +1,80 @@
 #include "data_processor.h"
+#include "cpu_features.h"
+#include "profiler.h"
+
+#include <algorithm>
 #include <stdexcept> 
+#include <thread>
+#include <utility>
+
+#if DNN_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Below this many pixels the cost of spawning threads outweighs the work (~8k MNIST images)
+const std::size_t kParallelThresholdPixels = std::size_t(1) << 23;
+
+void normalize_scalar(const unsigned char* in, float* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        // Normalize pixel value from [0, 255] to [0.0, 1.0]
+        out[i] = static_cast<float>(in[i]) / 255.0f;
+    }
+}
+
+#if DNN_X86
+// Division (not multiplication by 1/255) keeps results bit-identical to the scalar path.
+void normalize_sse2(const unsigned char* in, float* out, std::size_t n) {
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i lo16 = _mm_unpacklo_epi8(bytes, zero);
+        __m128i hi16 = _mm_unpackhi_epi8(bytes, zero);
+        _mm_storeu_ps(out + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo16, zero)), scale));
+        _mm_storeu_ps(out + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo16, zero)), scale));
+        _mm_storeu_ps(out + i + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi16, zero)), scale));
+        _mm_storeu_ps(out + i + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi16, zero)), scale));
+    }
+    normalize_scalar(in + i, out + i, n - i);
+}
+
+DNN_TARGET("avx2")
+void normalize_avx2(const unsigned char* in, float* out, std::size_t n) {
+    const __m256 scale = _mm256_set1_ps(255.0f);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m256i lo = _mm256_cvtepu8_epi32(bytes);
+        __m256i hi = _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8));
+        _mm256_storeu_ps(out + i, _mm256_div_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(out + i + 8, _mm256_div_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+    normalize_scalar(in + i, out + i, n - i);
+}
+#endif
+
+} // namespace
 
 DataProcessor::DataProcessor() {
 }
 
+void DataProcessor::normalize_pixels(const unsigned char* in, float* out, std::size_t n) {
+#if DNN_X86
+    if (CpuFeatures::has_avx2()) {
+        normalize_avx2(in, out, n);
+        return;
+    }
+    if (CpuFeatures::has_sse2()) {
+        normalize_sse2(in, out, n);
+        return;
+    }
+#endif
+    normalize_scalar(in, out, n);
+}
+
 std::vector<std::vector<float>> DataProcessor::process_images(
     const std::vector<std::vector<unsigned char>>& raw_images) {
     
@@ -16,16 +87,76 @@ std::vector<std::vector<float>> DataProcessor::process_images(
             continue;
         }
         
-        std::vector<float> processed_image;
-        processed_image.reserve(raw_image.size());
+        std::vector<float> processed_image(raw_image.size());
+        normalize_pixels(raw_image.data(), processed_image.data(), raw_image.size());
+        processed_images.push_back(std::move(processed_image));
+    }
+    return processed_images;
+}
+
+Batch DataProcessor::process_images(const MnistImageView& raw_images) {
+    Batch batch;
+    process_images_into(raw_images.pixels(), raw_images.image_size(), batch);
+    return batch;
+}
+
+void DataProcessor::process_images_into(Span<const unsigned char> pixels, std::size_t image_size, Batch& out) {
+    DNN_PROFILE_SCOPE(Profiler::Phase::Process);
+    if (image_size == 0 || pixels.size() % image_size != 0) {
+        throw std::invalid_argument("process_images_into: pixel buffer is not a whole number of images.");
+    }
+    std::size_t num_images = pixels.size() / image_size;
+    out.resize(num_images, image_size);
 
-        for (unsigned char pixel_value : raw_image) {
-            // Normalize pixel value from [0, 255] to [0.0, 1.0]
-            processed_image.push_back(static_cast<float>(pixel_value) / 255.0f);
+    std::size_t num_threads = 1;
+    if (pixels.size() >= kParallelThresholdPixels) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+        num_threads = std::min(num_threads, num_images);
+    }
+    if (num_threads <= 1) {
+        normalize_pixels(pixels.data(), out.data(), pixels.size());
+        return;
+    }
+
+    // Split on image boundaries so each thread writes whole rows
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads - 1);
+    std::size_t per_thread = (num_images + num_threads - 1) / num_threads;
+    for (std::size_t t = 1; t < num_threads; ++t) {
+        std::size_t begin = t * per_thread;
+        std::size_t end = std::min(num_images, begin + per_thread);
+        if (begin >= end) {
+            break;
         }
-        processed_images.push_back(processed_image);
+        workers.emplace_back([&, begin, end]() {
+            normalize_pixels(pixels.data() + begin * image_size, out.data() + begin * image_size,
+                             (end - begin) * image_size);
+        });
+    }
+    normalize_pixels(pixels.data(), out.data(), std::min(num_images, per_thread) * image_size);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void DataProcessor::append_sparse_pixels(const unsigned char* in, std::size_t n, SparseBatch& out) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if (in[i] != 0) {
+            out.push(static_cast<uint32_t>(i), static_cast<float>(in[i]) / 255.0f);
+        }
+    }
+    out.end_row();
+}
+
+void DataProcessor::process_images_sparse(Span<const unsigned char> pixels, std::size_t image_size, SparseBatch& out) {
+    DNN_PROFILE_SCOPE(Profiler::Phase::Process);
+    if (image_size == 0 || pixels.size() % image_size != 0) {
+        throw std::invalid_argument("process_images_sparse: pixel buffer is not a whole number of images.");
+    }
+    out.clear(image_size);
+    for (std::size_t offset = 0; offset < pixels.size(); offset += image_size) {
+        append_sparse_pixels(pixels.data() + offset, image_size, out);
     }
-    return processed_images;
 }
 
 std::vector<float> DataProcessor::process_labels(
@@ -42,4 +173,4 @@ std::vector<float> DataProcessor::process_labels(
         processed_labels.push_back(static_cast<float>(label_value));
     }
     return processed_labels;
-}
\ No newline at end of file
+}
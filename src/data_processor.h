@@ -2,8 +2,14 @@
 #define DATA_PROCESSOR_H
 
 #include <vector>
+#include <cstddef>
 #include <cstdint> // For unsigned char if needed, though vector<unsigned char> is fine
 
+#include "mnist_reader.h"
+#include "sparse_batch.h"
+#include "span.h"
+#include "tensor.h"
+
 class DataProcessor {
 public:
     // Constructor (if needed for any setup, otherwise default is fine)
@@ -14,11 +20,31 @@ public:
     // Output: Vector of images, where each image is a vector of float pixels
     std::vector<std::vector<float>> process_images(const std::vector<std::vector<unsigned char>>& raw_images);
 
+    // Normalizes every image of a mapped IDX file into one contiguous batch
+    // Output: count() x (rows() * cols()) row-major, 64-byte aligned
+    Batch process_images(const MnistImageView& raw_images);
+
+    // Normalizes a contiguous buffer of images (image_size pixels each) into out.
+    // out is resized to (pixels.size() / image_size) x image_size; its storage is reused when large enough.
+    // Large inputs are split across threads.
+    void process_images_into(Span<const unsigned char> pixels, std::size_t image_size, Batch& out);
+
+    // Normalizes a contiguous buffer of images into CSR form, keeping only nonzero pixels.
+    // out is cleared first; its storage is reused when large enough.
+    void process_images_sparse(Span<const unsigned char> pixels, std::size_t image_size, SparseBatch& out);
+
     // Converts labels to a suitable float format for the network
     // (Further processing like one-hot encoding could be a separate step or class)
     // Input: Vector of unsigned char labels
     // Output: Vector of float labels
     std::vector<float> process_labels(const std::vector<unsigned char>& raw_labels);
+
+    // Single-threaded u8 -> f32 scale of n pixels (x / 255), SIMD when the CPU allows
+    static void normalize_pixels(const unsigned char* in, float* out, std::size_t n);
+
+    // Appends one image of n pixels to out as a sparse row, with the same values
+    // normalize_pixels() would produce
+    static void append_sparse_pixels(const unsigned char* in, std::size_t n, SparseBatch& out);
 };
 
-#endif // DATA_PROCESSOR_H
\ No newline at end of file
+#endif // DATA_PROCESSOR_H
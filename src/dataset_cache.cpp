@@ -0,0 +1,193 @@
+#include "dataset_cache.h"
+#include "atomic_file.h"
+#include "data_processor.h"
+#include "mnist_reader.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[8] = {'D', 'N', 'N', 'C', 'A', 'C', 'H', 'E'};
+const std::size_t kHeaderSize = 64;
+const std::size_t kBlobAlignment = 64;
+const std::size_t kImagesPerWrite = 1024;
+
+const uint64_t kFnvOffset = 1469598103934665603ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t fnv1a(uint64_t hash, const void* data, std::size_t n) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < n; ++i) {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+std::size_t align_up(std::size_t n) {
+    return (n + kBlobAlignment - 1) / kBlobAlignment * kBlobAlignment;
+}
+
+void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+void put_u64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+}
+
+uint32_t get_u32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+uint64_t get_u64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// Size, mtime and the first header_bytes bytes of a source file
+uint64_t hash_source(uint64_t hash, const std::string& path, std::size_t header_bytes) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        throw std::runtime_error("Cannot stat file: " + path);
+    }
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+    int64_t mtime[2] = {static_cast<int64_t>(st.st_mtim.tv_sec), static_cast<int64_t>(st.st_mtim.tv_nsec)};
+    hash = fnv1a(hash, &size, sizeof(size));
+    hash = fnv1a(hash, mtime, sizeof(mtime));
+
+    unsigned char header[16] = {};
+    std::ifstream file(path, std::ios::binary);
+    file.read(reinterpret_cast<char*>(header), static_cast<std::streamsize>(std::min(header_bytes, sizeof(header))));
+    return fnv1a(hash, header, sizeof(header));
+}
+
+void write_all(std::FILE* file, const void* data, std::size_t n, const std::string& path) {
+    if (n > 0 && std::fwrite(data, 1, n, file) != n) {
+        throw std::runtime_error("DatasetCache: write failed: " + path);
+    }
+}
+
+void pad_to(std::FILE* file, std::size_t& pos, std::size_t target, const std::string& path) {
+    static const unsigned char zeros[kBlobAlignment] = {};
+    write_all(file, zeros, target - pos, path);
+    pos = target;
+}
+
+void write_cache(const MnistImageView& images, const MnistLabelView& labels, uint64_t key,
+                 std::FILE* file, const std::string& path) {
+    const std::size_t width = images.image_size();
+    const std::size_t labels_offset = align_up(kHeaderSize + images.count() * width * sizeof(float));
+    const std::size_t file_size = labels_offset + labels.count();
+
+    unsigned char header[kHeaderSize] = {};
+    std::memcpy(header, kMagic, sizeof(kMagic));
+    put_u32(header + 8, DatasetCache::kVersion);
+    put_u32(header + 12, static_cast<uint32_t>(images.count()));
+    put_u32(header + 16, static_cast<uint32_t>(images.rows()));
+    put_u32(header + 20, static_cast<uint32_t>(images.cols()));
+    put_u64(header + 24, key);
+    put_u64(header + 32, file_size);
+    std::size_t pos = 0;
+    write_all(file, header, kHeaderSize, path);
+    pos += kHeaderSize;
+
+    // Normalize in slices so the writer never holds more than kImagesPerWrite float images
+    Batch slice;
+    for (std::size_t first = 0; first < images.count(); first += kImagesPerWrite) {
+        std::size_t n = std::min(kImagesPerWrite, images.count() - first);
+        slice.resize(n, width);
+        DataProcessor::normalize_pixels(images.image(first).data(), slice.data(), n * width);
+        write_all(file, slice.data(), slice.size() * sizeof(float), path);
+        pos += slice.size() * sizeof(float);
+    }
+    pad_to(file, pos, labels_offset, path);
+    write_all(file, labels.labels().data(), labels.count(), path);
+}
+
+} // namespace
+
+uint64_t DatasetCache::source_key(const std::string& images_path, const std::string& labels_path) {
+    const uint32_t version = kVersion;
+    const uint32_t probe = 1; // Host byte order
+    uint64_t hash = fnv1a(kFnvOffset, &version, sizeof(version));
+    hash = fnv1a(hash, &probe, sizeof(probe));
+    hash = hash_source(hash, images_path, 16); // IDX3 header: magic, count, rows, cols
+    return hash_source(hash, labels_path, 8);  // IDX1 header: magic, count
+}
+
+DatasetCache::DatasetCache(const std::string& cache_path, const std::string& images_path,
+                           const std::string& labels_path)
+    : rebuilt_(false), count_(0), rows_(0), cols_(0), images_(nullptr) {
+    DNN_PROFILE_SCOPE(Profiler::Phase::Read);
+    const uint64_t key = source_key(images_path, labels_path);
+    if (try_open(cache_path, key)) {
+        return;
+    }
+
+    MnistImageView images(images_path);
+    MnistLabelView labels(labels_path);
+    if (images.count() != labels.count()) {
+        throw std::runtime_error("DatasetCache: " + images_path + " and " + labels_path + " hold different counts.");
+    }
+    write_file_atomically(cache_path, [&](std::FILE* file, const std::string& tmp_path) {
+        write_cache(images, labels, key, file, tmp_path);
+    });
+    if (!try_open(cache_path, key)) {
+        throw std::runtime_error("DatasetCache: " + cache_path + " changed while it was being rebuilt.");
+    }
+    rebuilt_ = true;
+}
+
+bool DatasetCache::try_open(const std::string& cache_path, uint64_t key) {
+    if (::access(cache_path.c_str(), R_OK) != 0) {
+        return false;
+    }
+    MappedFile file(cache_path);
+    const unsigned char* p = file.data();
+    if (file.size() < kHeaderSize || std::memcmp(p, kMagic, sizeof(kMagic)) != 0 ||
+        get_u32(p + 8) != kVersion || get_u64(p + 24) != key || get_u64(p + 32) != file.size()) {
+        return false;
+    }
+    std::size_t count = get_u32(p + 12);
+    std::size_t rows = get_u32(p + 16);
+    std::size_t cols = get_u32(p + 20);
+    // A corrupt header must not wrap the size check; overflow just means "rebuild"
+    std::size_t pixel_bytes;
+    if (__builtin_mul_overflow(count, rows, &pixel_bytes) || __builtin_mul_overflow(pixel_bytes, cols, &pixel_bytes) ||
+        __builtin_mul_overflow(pixel_bytes, sizeof(float), &pixel_bytes) || pixel_bytes > file.size()) {
+        return false;
+    }
+    std::size_t labels_offset = align_up(kHeaderSize + pixel_bytes);
+    if (labels_offset + count != file.size()) {
+        return false;
+    }
+
+    file_ = std::move(file);
+    count_ = count;
+    rows_ = rows;
+    cols_ = cols;
+    images_ = reinterpret_cast<const float*>(file_.data() + kHeaderSize);
+    labels_ = Span<const unsigned char>(file_.data() + labels_offset, count);
+    return true;
+}
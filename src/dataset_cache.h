@@ -0,0 +1,66 @@
+#ifndef DATASET_CACHE_H
+#define DATASET_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.h"
+#include "span.h"
+
+// Preprocessed dataset cache: the normalized float images and u8 labels of an IDX
+// image/label pair, stored so one mmap makes them usable as-is.
+//
+//   offset 0   header (64 bytes): magic "DNNCACHE", version, count, rows, cols,
+//              source key, file size
+//   offset 64  count x (rows * cols) float32 pixels in [0, 1], row-major
+//   ...        count u8 labels, starting on a 64-byte boundary
+//
+// The key hashes the size, mtime and IDX header of both source files, plus the format
+// version and the host byte order (a cache is a local artifact, written in native
+// order). A cache whose key, size or layout does not match is rebuilt: the new file is
+// written with write_file_atomically (unique temporary name, flushed, renamed over the
+// old one, directory synced), so concurrent jobs and threads sharing a cache path each
+// see either a complete old file or a complete new one. Pixel data is not checksummed on
+// open; that would cost as much as the parse the cache exists to skip.
+class DatasetCache {
+public:
+    static const uint32_t kVersion = 1;
+
+    // Maps cache_path if it is valid for the source files, otherwise rebuilds it from them
+    // first. Throws std::runtime_error if the sources are invalid or the cache cannot be written.
+    DatasetCache(const std::string& cache_path, const std::string& images_path, const std::string& labels_path);
+
+    DatasetCache(const DatasetCache&) = delete;
+    DatasetCache& operator=(const DatasetCache&) = delete;
+
+    // True when this open had to (re)build the file
+    bool rebuilt() const { return rebuilt_; }
+
+    std::size_t count() const { return count_; }
+    std::size_t rows() const { return rows_; }
+    std::size_t cols() const { return cols_; }
+    std::size_t image_size() const { return rows_ * cols_; }
+
+    // count() x image_size() normalized pixels, 64-byte aligned
+    const float* images() const { return images_; }
+    const float* image(std::size_t i) const { return images_ + i * image_size(); }
+    Span<const unsigned char> labels() const { return labels_; }
+
+    // Key a cache for these sources must carry. Throws std::runtime_error if either file is missing.
+    static uint64_t source_key(const std::string& images_path, const std::string& labels_path);
+
+private:
+    // Maps cache_path; false (with the mapping released) if it is missing or does not match key
+    bool try_open(const std::string& cache_path, uint64_t key);
+
+    MappedFile file_;
+    bool rebuilt_;
+    std::size_t count_;
+    std::size_t rows_;
+    std::size_t cols_;
+    const float* images_;
+    Span<const unsigned char> labels_;
+};
+
+#endif // DATASET_CACHE_H
@@ -0,0 +1,119 @@
+#include "evaluator.h"
+#include "activation_functions.h"
+#include "data_processor.h"
+#include "loss_functions.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+double EvalStats::precision(std::size_t c) const {
+    std::size_t predicted = 0;
+    for (std::size_t t = 0; t < num_classes; ++t) {
+        predicted += count(t, c);
+    }
+    return predicted > 0 ? static_cast<double>(count(c, c)) / static_cast<double>(predicted) : 0.0;
+}
+
+std::size_t EvalStats::support(std::size_t c) const {
+    std::size_t actual = 0;
+    for (std::size_t p = 0; p < num_classes; ++p) {
+        actual += count(c, p);
+    }
+    return actual;
+}
+
+double EvalStats::recall(std::size_t c) const {
+    const std::size_t actual = support(c);
+    return actual > 0 ? static_cast<double>(count(c, c)) / static_cast<double>(actual) : 0.0;
+}
+
+Evaluator::Evaluator(const NeuralNetwork& network, const EvaluatorConfig& config)
+    : network_(network), config_(config), pool_(config.num_threads) {
+    if (config_.batch_size == 0) {
+        throw std::invalid_argument("Evaluator: batch_size must be non-zero.");
+    }
+    workers_.resize(pool_.size());
+    const std::size_t width = network_.input_size();
+    const std::size_t classes = network_.output_size();
+    const std::size_t rows = config_.batch_size;
+    for (Worker& worker : workers_) {
+        worker.workspace.reserve(Workspace::bytes_for<float>(rows * width) + Workspace::bytes_for<float>(rows * classes) +
+                                 network_.workspace_bytes(rows));
+        worker.input.attach(worker.workspace.allocate<float>(rows * width), rows * width);
+        worker.probabilities.attach(worker.workspace.allocate<float>(rows * classes), rows * classes);
+        network_.bind_buffers(worker.buffers, worker.workspace, rows);
+        worker.sparse_input.reserve(rows, rows * width);
+        worker.predicted.resize(rows);
+        worker.row.resize(classes);
+        worker.confusion.resize(classes * classes);
+    }
+}
+
+EvalStats Evaluator::evaluate(const MnistImageView& images, Span<const unsigned char> labels) {
+    const std::size_t width = network_.input_size();
+    const std::size_t classes = network_.output_size();
+    if (images.image_size() != width || labels.size() != images.count()) {
+        throw std::invalid_argument("Evaluator::evaluate: dataset shape does not match the network.");
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const std::size_t count = images.count();
+    const std::size_t num_workers = workers_.size();
+    pool_.run([&](std::size_t t) {
+        Worker& worker = workers_[t];
+        std::fill(worker.confusion.begin(), worker.confusion.end(), 0);
+        worker.loss = 0.0;
+        const std::size_t end = (t + 1) * count / num_workers;
+        for (std::size_t first = t * count / num_workers; first < end; first += config_.batch_size) {
+            const std::size_t rows = std::min(config_.batch_size, end - first);
+            const unsigned char* pixels = images.image(first).data();
+            const Tensor2D<float>* logits;
+            if (config_.sparse) {
+                worker.sparse_input.clear(width);
+                for (std::size_t r = 0; r < rows; ++r) {
+                    DataProcessor::append_sparse_pixels(pixels + r * width, width, worker.sparse_input);
+                }
+                logits = &network_.forward(worker.sparse_input, worker.buffers);
+            } else {
+                worker.input.resize(rows, width);
+                DataProcessor::normalize_pixels(pixels, worker.input.data(), rows * width);
+                logits = &network_.forward(worker.input, worker.buffers);
+            }
+
+            worker.probabilities.resize(rows, classes);
+            Activations::softmax<float>(logits->flat(), worker.probabilities.flat(), classes);
+            argmax_rows(*logits, Span<unsigned char>(worker.predicted.data(), rows));
+            for (std::size_t r = 0; r < rows; ++r) {
+                const unsigned char label = labels[first + r];
+                const float* p = worker.probabilities.data() + r * classes;
+                std::copy(p, p + classes, worker.row.begin());
+                worker.loss += LossFunctions::categorical_cross_entropy_with_index(worker.row, label);
+                ++worker.confusion[label * classes + worker.predicted[r]];
+            }
+        }
+    });
+
+    EvalStats stats;
+    stats.samples = count;
+    stats.num_classes = classes;
+    stats.confusion.assign(classes * classes, 0);
+    double loss_sum = 0.0;
+    for (const Worker& worker : workers_) {
+        for (std::size_t i = 0; i < stats.confusion.size(); ++i) {
+            stats.confusion[i] += worker.confusion[i];
+        }
+        loss_sum += worker.loss;
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (count > 0) {
+        std::size_t correct = 0;
+        for (std::size_t c = 0; c < classes; ++c) {
+            correct += stats.count(c, c);
+        }
+        stats.accuracy = static_cast<double>(correct) / static_cast<double>(count);
+        stats.mean_loss = loss_sum / static_cast<double>(count);
+        stats.images_per_second = static_cast<double>(count) / stats.seconds;
+    }
+    return stats;
+}
@@ -0,0 +1,79 @@
+#ifndef EVALUATOR_H
+#define EVALUATOR_H
+
+#include <cstddef>
+#include <vector>
+
+#include "mnist_reader.h"
+#include "neural_network.h"
+#include "sparse_batch.h"
+#include "span.h"
+#include "tensor.h"
+#include "thread_pool.h"
+#include "workspace.h"
+
+struct EvaluatorConfig {
+    std::size_t batch_size = 256; // Rows per forward pass within a thread's shard
+    std::size_t num_threads = 0;  // 0 = one per hardware thread
+    // Feed the network CSR batches (forward() falls back to dense for dense batches)
+    bool sparse = true;
+};
+
+struct EvalStats {
+    std::size_t samples = 0;
+    std::size_t num_classes = 0;
+    double accuracy = 0.0;
+    double mean_loss = 0.0; // Mean categorical_cross_entropy_with_index of the softmax outputs
+    double seconds = 0.0;
+    double images_per_second = 0.0;
+    // num_classes x num_classes counts, row = true class, column = predicted class
+    std::vector<std::size_t> confusion;
+
+    std::size_t count(std::size_t true_class, std::size_t predicted_class) const {
+        return confusion[true_class * num_classes + predicted_class];
+    }
+    // Samples whose true class is c
+    std::size_t support(std::size_t c) const;
+    // Fraction of the predictions of class c that were right; 0 if c was never predicted
+    double precision(std::size_t c) const;
+    // Fraction of the samples of class c predicted as c; 0 if there were none
+    double recall(std::size_t c) const;
+};
+
+// Data-parallel evaluation of a network on a labelled IDX image set.
+// The set is cut into one contiguous shard per thread. Each worker normalizes its shard
+// batch_size rows at a time into its own buffers, runs the forward pass, and tallies
+// its own confusion matrix and loss; the matrices are summed once at the end. Worker
+// buffers are sized at construction, so the parallel part never touches the heap, and
+// the result does not depend on the thread count except for the rounding of the loss sum.
+class Evaluator {
+public:
+    // network must outlive the evaluator and keep its layer sizes
+    Evaluator(const NeuralNetwork& network, const EvaluatorConfig& config);
+
+    std::size_t num_threads() const { return pool_.size(); }
+
+    // Throws std::invalid_argument if the image size or label count does not match, and
+    // std::out_of_range for a label outside the network's classes
+    EvalStats evaluate(const MnistImageView& images, Span<const unsigned char> labels);
+
+private:
+    struct Worker {
+        Workspace workspace;
+        Tensor2D<float> input;
+        SparseBatch sparse_input;
+        Tensor2D<float> probabilities;
+        std::vector<unsigned char> predicted;
+        std::vector<double> row; // One row of probabilities, widened for the loss
+        PassBuffers buffers;
+        std::vector<std::size_t> confusion;
+        double loss = 0.0;
+    };
+
+    const NeuralNetwork& network_;
+    EvaluatorConfig config_;
+    ThreadPool pool_;
+    std::vector<Worker> workers_;
+};
+
+#endif // EVALUATOR_H
@@ -0,0 +1,263 @@
+#include "gemm.h"
+#include "cpu_features.h"
+#include "tensor.h"
+
+#include <algorithm>
+
+#if DNN_X86
+#include <immintrin.h>
+#endif
+
+namespace Gemm {
+
+    namespace {
+
+        // Register block: 6 rows x 16 columns = 12 AVX2 accumulators
+        const std::size_t MR = 6;
+        const std::size_t NR = 16;
+
+        // Cache blocks: an MC x KC block of A (~72 KB) stays in L2,
+        // a KC x NR sliver of B (16 KB) in L1, the KC x NC panel of B in L3.
+        const std::size_t MC = 72;
+        const std::size_t KC = 256;
+        const std::size_t NC = 1024;
+
+        // Packs op(A)[i0:i0+mc, k0:k0+kc] into MR-row slivers, k-major within each
+        // sliver, zero-padding the last sliver to MR rows.
+        void pack_a(bool trans_a, const float* A, std::size_t lda,
+                    std::size_t i0, std::size_t k0, std::size_t mc, std::size_t kc, float* packed) {
+            for (std::size_t ir = 0; ir < mc; ir += MR) {
+                std::size_t mr = std::min(MR, mc - ir);
+                for (std::size_t k = 0; k < kc; ++k) {
+                    for (std::size_t r = 0; r < mr; ++r) {
+                        std::size_t i = i0 + ir + r;
+                        std::size_t kk = k0 + k;
+                        *packed++ = trans_a ? A[kk * lda + i] : A[i * lda + kk];
+                    }
+                    for (std::size_t r = mr; r < MR; ++r) {
+                        *packed++ = 0.0f;
+                    }
+                }
+            }
+        }
+
+        // Packs op(B)[k0:k0+kc, j0:j0+nc] into NR-column slivers, k-major within each
+        // sliver, zero-padding the last sliver to NR columns.
+        void pack_b(bool trans_b, const float* B, std::size_t ldb,
+                    std::size_t k0, std::size_t j0, std::size_t kc, std::size_t nc, float* packed) {
+            for (std::size_t jr = 0; jr < nc; jr += NR) {
+                std::size_t nr = std::min(NR, nc - jr);
+                for (std::size_t k = 0; k < kc; ++k) {
+                    std::size_t kk = k0 + k;
+                    if (!trans_b) {
+                        const float* src = B + kk * ldb + j0 + jr;
+                        std::copy(src, src + nr, packed);
+                    } else {
+                        for (std::size_t c = 0; c < nr; ++c) {
+                            packed[c] = B[(j0 + jr + c) * ldb + kk];
+                        }
+                    }
+                    std::fill(packed + nr, packed + NR, 0.0f);
+                    packed += NR;
+                }
+            }
+        }
+
+        // acc[MR][NR] = sum_k a[k][:] outer b[k][:]
+        void micro_kernel_portable(std::size_t kc, const float* a, const float* b, float* acc) {
+            std::fill(acc, acc + MR * NR, 0.0f);
+            for (std::size_t k = 0; k < kc; ++k) {
+                for (std::size_t r = 0; r < MR; ++r) {
+                    float ar = a[r];
+                    float* acc_row = acc + r * NR;
+                    for (std::size_t c = 0; c < NR; ++c) {
+                        acc_row[c] += ar * b[c];
+                    }
+                }
+                a += MR;
+                b += NR;
+            }
+        }
+
+#if DNN_X86
+        DNN_TARGET("avx2,fma")
+        void micro_kernel_avx2(std::size_t kc, const float* a, const float* b, float* acc) {
+            __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+            __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+            __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+            __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+            __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+            __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+            for (std::size_t k = 0; k < kc; ++k) {
+                __m256 b0 = _mm256_load_ps(b);
+                __m256 b1 = _mm256_load_ps(b + 8);
+                __m256 a0 = _mm256_broadcast_ss(a + 0);
+                __m256 a1 = _mm256_broadcast_ss(a + 1);
+                c00 = _mm256_fmadd_ps(a0, b0, c00); c01 = _mm256_fmadd_ps(a0, b1, c01);
+                c10 = _mm256_fmadd_ps(a1, b0, c10); c11 = _mm256_fmadd_ps(a1, b1, c11);
+                __m256 a2 = _mm256_broadcast_ss(a + 2);
+                __m256 a3 = _mm256_broadcast_ss(a + 3);
+                c20 = _mm256_fmadd_ps(a2, b0, c20); c21 = _mm256_fmadd_ps(a2, b1, c21);
+                c30 = _mm256_fmadd_ps(a3, b0, c30); c31 = _mm256_fmadd_ps(a3, b1, c31);
+                __m256 a4 = _mm256_broadcast_ss(a + 4);
+                __m256 a5 = _mm256_broadcast_ss(a + 5);
+                c40 = _mm256_fmadd_ps(a4, b0, c40); c41 = _mm256_fmadd_ps(a4, b1, c41);
+                c50 = _mm256_fmadd_ps(a5, b0, c50); c51 = _mm256_fmadd_ps(a5, b1, c51);
+                a += MR;
+                b += NR;
+            }
+            _mm256_store_ps(acc + 0 * NR, c00); _mm256_store_ps(acc + 0 * NR + 8, c01);
+            _mm256_store_ps(acc + 1 * NR, c10); _mm256_store_ps(acc + 1 * NR + 8, c11);
+            _mm256_store_ps(acc + 2 * NR, c20); _mm256_store_ps(acc + 2 * NR + 8, c21);
+            _mm256_store_ps(acc + 3 * NR, c30); _mm256_store_ps(acc + 3 * NR + 8, c31);
+            _mm256_store_ps(acc + 4 * NR, c40); _mm256_store_ps(acc + 4 * NR + 8, c41);
+            _mm256_store_ps(acc + 5 * NR, c50); _mm256_store_ps(acc + 5 * NR + 8, c51);
+        }
+#endif
+
+        typedef void (*MicroKernel)(std::size_t, const float*, const float*, float*);
+
+        MicroKernel select_micro_kernel() {
+#if DNN_X86
+            if (CpuFeatures::has_avx2() && CpuFeatures::has_fma()) {
+                return micro_kernel_avx2;
+            }
+#endif
+            return micro_kernel_portable;
+        }
+
+        void scale_c(std::size_t M, std::size_t N, float beta, float* C, std::size_t ldc) {
+            if (beta == 1.0f) {
+                return;
+            }
+            for (std::size_t i = 0; i < M; ++i) {
+                float* row = C + i * ldc;
+                if (beta == 0.0f) {
+                    std::fill(row, row + N, 0.0f);
+                } else {
+                    for (std::size_t j = 0; j < N; ++j) {
+                        row[j] *= beta;
+                    }
+                }
+            }
+        }
+
+    } // namespace
+
+    void sgemm(bool trans_a, bool trans_b,
+               std::size_t M, std::size_t N, std::size_t K,
+               float alpha,
+               const float* A, std::size_t lda,
+               const float* B, std::size_t ldb,
+               float beta,
+               float* C, std::size_t ldc) {
+        if (M == 0 || N == 0) {
+            return;
+        }
+        scale_c(M, N, beta, C, ldc);
+        if (K == 0 || alpha == 0.0f) {
+            return;
+        }
+
+        static const MicroKernel micro_kernel = select_micro_kernel();
+
+        // Packing buffers are reused across calls on the same thread
+        thread_local Tensor2D<float> packed_a;
+        thread_local Tensor2D<float> packed_b;
+        thread_local Tensor2D<float> tile;
+        packed_a.resize(1, ((MC + MR - 1) / MR) * MR * KC);
+        packed_b.resize(1, KC * ((NC + NR - 1) / NR) * NR);
+        tile.resize(MR, NR);
+
+        for (std::size_t j0 = 0; j0 < N; j0 += NC) {
+            std::size_t nc = std::min(NC, N - j0);
+            for (std::size_t k0 = 0; k0 < K; k0 += KC) {
+                std::size_t kc = std::min(KC, K - k0);
+                pack_b(trans_b, B, ldb, k0, j0, kc, nc, packed_b.data());
+
+                for (std::size_t i0 = 0; i0 < M; i0 += MC) {
+                    std::size_t mc = std::min(MC, M - i0);
+                    pack_a(trans_a, A, lda, i0, k0, mc, kc, packed_a.data());
+
+                    for (std::size_t jr = 0; jr < nc; jr += NR) {
+                        std::size_t nr = std::min(NR, nc - jr);
+                        const float* b_sliver = packed_b.data() + jr * kc;
+                        for (std::size_t ir = 0; ir < mc; ir += MR) {
+                            std::size_t mr = std::min(MR, mc - ir);
+                            const float* a_sliver = packed_a.data() + ir * kc;
+                            micro_kernel(kc, a_sliver, b_sliver, tile.data());
+
+                            // C += alpha * tile, clipped to the valid edge
+                            float* c = C + (i0 + ir) * ldc + j0 + jr;
+                            for (std::size_t r = 0; r < mr; ++r) {
+                                const float* t = tile.data() + r * NR;
+                                float* c_row = c + r * ldc;
+                                for (std::size_t col = 0; col < nr; ++col) {
+                                    c_row[col] += alpha * t[col];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void dgemm(bool trans_a, bool trans_b,
+               std::size_t M, std::size_t N, std::size_t K,
+               double alpha,
+               const double* A, std::size_t lda,
+               const double* B, std::size_t ldb,
+               double beta,
+               double* C, std::size_t ldc) {
+        for (std::size_t i = 0; i < M; ++i) {
+            double* c = C + i * ldc;
+            for (std::size_t j = 0; j < N; ++j) {
+                c[j] = (beta == 0.0) ? 0.0 : beta * c[j];
+            }
+            if (!trans_b) {
+                // C[i,:] += a_ik * B[k,:], contiguous in j
+                for (std::size_t k = 0; k < K; ++k) {
+                    // No skip for a == 0: 0 * Inf/NaN in B must still reach C, as in sgemm
+                    double a = alpha * (trans_a ? A[k * lda + i] : A[i * lda + k]);
+                    const double* b = B + k * ldb;
+                    for (std::size_t j = 0; j < N; ++j) {
+                        c[j] += a * b[j];
+                    }
+                }
+            } else {
+                // C[i,j] += dot(op(A)[i,:], B[j,:]), B rows contiguous in k
+                for (std::size_t j = 0; j < N; ++j) {
+                    const double* b = B + j * ldb;
+                    double sum = 0.0;
+                    for (std::size_t k = 0; k < K; ++k) {
+                        sum += (trans_a ? A[k * lda + i] : A[i * lda + k]) * b[k];
+                    }
+                    c[j] += alpha * sum;
+                }
+            }
+        }
+    }
+
+    void sgemm_reference(bool trans_a, bool trans_b,
+                         std::size_t M, std::size_t N, std::size_t K,
+                         float alpha,
+                         const float* A, std::size_t lda,
+                         const float* B, std::size_t ldb,
+                         float beta,
+                         float* C, std::size_t ldc) {
+        for (std::size_t i = 0; i < M; ++i) {
+            for (std::size_t j = 0; j < N; ++j) {
+                double sum = 0.0;
+                for (std::size_t k = 0; k < K; ++k) {
+                    float a = trans_a ? A[k * lda + i] : A[i * lda + k];
+                    float b = trans_b ? B[j * ldb + k] : B[k * ldb + j];
+                    sum += static_cast<double>(a) * b;
+                }
+                float prev = (beta == 0.0f) ? 0.0f : beta * C[i * ldc + j];
+                C[i * ldc + j] = alpha * static_cast<float>(sum) + prev;
+            }
+        }
+    }
+
+} // namespace Gemm
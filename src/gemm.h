@@ -0,0 +1,59 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+
+// Self-contained single-precision matrix multiply (no BLAS dependency).
+// Cache-blocked in the Goto/BLIS style: B is packed into KC x NC panels, A into
+// MC x KC blocks, and an MR x NR register-blocked micro-kernel does the inner
+// work (AVX2+FMA when available, portable C++ otherwise).
+namespace Gemm {
+
+    /**
+     * @brief C = alpha * op(A) * op(B) + beta * C, all matrices row-major.
+     * op(A) is M x K (A is K x M when trans_a), op(B) is K x N (B is N x K when trans_b).
+     * lda/ldb/ldc are row strides in elements. beta == 0 ignores C's previous contents.
+     */
+    void sgemm(bool trans_a, bool trans_b,
+               std::size_t M, std::size_t N, std::size_t K,
+               float alpha,
+               const float* A, std::size_t lda,
+               const float* B, std::size_t ldb,
+               float beta,
+               float* C, std::size_t ldc);
+
+    // Double-precision counterpart with the same contract. Portable and loop-ordered for
+    // contiguous inner loops rather than register-blocked: it serves validation runs, not
+    // the training fast path.
+    void dgemm(bool trans_a, bool trans_b,
+               std::size_t M, std::size_t N, std::size_t K,
+               double alpha,
+               const double* A, std::size_t lda,
+               const double* B, std::size_t ldb,
+               double beta,
+               double* C, std::size_t ldc);
+
+    // Overloads picking sgemm or dgemm from the scalar type, for code templated on it
+    inline void gemm(bool trans_a, bool trans_b, std::size_t M, std::size_t N, std::size_t K,
+                     float alpha, const float* A, std::size_t lda, const float* B, std::size_t ldb,
+                     float beta, float* C, std::size_t ldc) {
+        sgemm(trans_a, trans_b, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+    inline void gemm(bool trans_a, bool trans_b, std::size_t M, std::size_t N, std::size_t K,
+                     double alpha, const double* A, std::size_t lda, const double* B, std::size_t ldb,
+                     double beta, double* C, std::size_t ldc) {
+        dgemm(trans_a, trans_b, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+    }
+
+    // Straightforward triple loop with the same contract, for validation and benchmarks
+    void sgemm_reference(bool trans_a, bool trans_b,
+                         std::size_t M, std::size_t N, std::size_t K,
+                         float alpha,
+                         const float* A, std::size_t lda,
+                         const float* B, std::size_t ldb,
+                         float beta,
+                         float* C, std::size_t ldc);
+
+} // namespace Gemm
+
+#endif // GEMM_H
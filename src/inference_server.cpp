@@ -0,0 +1,340 @@
+#include "inference_server.h"
+#include "activation_functions.h"
+#include "data_processor.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+void set_nonblocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        throw std::runtime_error("InferenceServer: cannot make socket non-blocking.");
+    }
+}
+
+double percentile(std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    std::size_t index = std::min(sorted.size() - 1, static_cast<std::size_t>(p * sorted.size()));
+    return sorted[index];
+}
+
+} // namespace
+
+void print_server_stats(std::ostream& out, const ServerStats& stats) {
+    std::ios::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(0) << stats.requests << " requests in " << std::setprecision(1)
+        << stats.seconds << " s: " << std::setprecision(0) << stats.requests_per_second << " req/s, mean batch "
+        << std::setprecision(1) << stats.mean_batch << ", latency p50 " << stats.p50_us << " us, p99 "
+        << stats.p99_us << " us" << std::endl;
+    out.flags(flags);
+}
+
+InferenceServer::InferenceServer(const NeuralNetwork& network, const InferenceServerConfig& config)
+    : network_(network), config_(config), listen_fd_(-1), stopping_(false), batches_(0),
+      stats_start_(Clock::now()) {
+    if (network.num_layers() == 0) {
+        throw std::invalid_argument("InferenceServer: the network has no layers.");
+    }
+    if (config_.max_batch == 0) {
+        throw std::invalid_argument("InferenceServer: max_batch must be non-zero.");
+    }
+    // With either limit at zero no connection is ever read, so clients would hang silently
+    if (config_.max_in_flight == 0) {
+        throw std::invalid_argument("InferenceServer: max_in_flight must be non-zero.");
+    }
+    if (config_.max_unsent_bytes == 0) {
+        throw std::invalid_argument("InferenceServer: max_unsent_bytes must be non-zero.");
+    }
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (config_.socket_path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("InferenceServer: socket path is too long: " + config_.socket_path);
+    }
+    std::memcpy(address.sun_path, config_.socket_path.c_str(), config_.socket_path.size() + 1);
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error("InferenceServer: cannot create socket.");
+    }
+    ::unlink(config_.socket_path.c_str());
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd_, 128) != 0) {
+        ::close(listen_fd_);
+        throw std::runtime_error("InferenceServer: cannot listen on " + config_.socket_path + ": " +
+                                 std::strerror(errno));
+    }
+    set_nonblocking(listen_fd_);
+
+    batch_.resize(config_.max_batch, network_.input_size());
+    probabilities_.resize(config_.max_batch * network_.output_size());
+    latencies_us_.reserve(1 << 16);
+}
+
+InferenceServer::~InferenceServer() {
+    for (Connection& connection : connections_) {
+        if (connection.fd >= 0) {
+            ::close(connection.fd);
+        }
+    }
+    ::close(listen_fd_);
+    ::unlink(config_.socket_path.c_str());
+}
+
+void InferenceServer::accept_clients() {
+    for (;;) {
+        int fd = ::accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            return; // EAGAIN: no more pending connections (other errors are retried on the next poll)
+        }
+        set_nonblocking(fd);
+        std::size_t slot = 0;
+        while (slot < connections_.size() && connections_[slot].fd >= 0) {
+            ++slot;
+        }
+        if (slot == connections_.size()) {
+            connections_.emplace_back();
+        }
+        Connection& connection = connections_[slot];
+        connection.fd = fd;
+        connection.in.clear();
+        connection.out.clear();
+        connection.out_offset = 0;
+        connection.unsent.clear();
+        connection.in_flight = 0;
+        connection.eof = false;
+        connection.broken = false;
+    }
+}
+
+bool InferenceServer::wants_input(const Connection& connection) const {
+    return !connection.eof && !connection.broken && connection.in_flight < config_.max_in_flight &&
+           connection.out.size() - connection.out_offset < config_.max_unsent_bytes;
+}
+
+void InferenceServer::read_client(std::size_t index) {
+    const std::size_t request_size = network_.input_size();
+    unsigned char buffer[1 << 16];
+    Connection& connection = connections_[index];
+    // Stop at the in-flight cap; the rest stays in the socket until the connection is polled again
+    while (wants_input(connection)) {
+        const std::size_t room = (config_.max_in_flight - connection.in_flight) * request_size - connection.in.size();
+        ssize_t got = ::recv(connection.fd, buffer, std::min(sizeof(buffer), room), 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (got < 0) {
+            connection.broken = true;
+            break;
+        }
+        if (got == 0) {
+            connection.eof = true; // A trailing partial request is dropped
+            connection.in.clear();
+            break;
+        }
+        connection.in.insert(connection.in.end(), buffer, buffer + got);
+
+        // Queue every complete request; keep the partial tail
+        std::size_t consumed = 0;
+        Clock::time_point now = Clock::now();
+        while (connection.in.size() - consumed >= request_size) {
+            Pending request;
+            request.connection = index;
+            request.arrived = now;
+            request.pixels.assign(connection.in.begin() + consumed, connection.in.begin() + consumed + request_size);
+            pending_.push_back(std::move(request));
+            ++connection.in_flight;
+            consumed += request_size;
+        }
+        connection.in.erase(connection.in.begin(), connection.in.begin() + consumed);
+    }
+}
+
+void InferenceServer::flush_client(Connection& connection) {
+    while (connection.out_offset < connection.out.size() && !connection.broken) {
+        ssize_t sent = ::send(connection.fd, connection.out.data() + connection.out_offset,
+                              connection.out.size() - connection.out_offset, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break; // Finished when poll reports the socket writable
+        }
+        if (sent <= 0) {
+            connection.broken = true;
+            break;
+        }
+        connection.out_offset += static_cast<std::size_t>(sent);
+    }
+    Clock::time_point now = Clock::now();
+    while (!connection.unsent.empty() && connection.unsent.front().end <= connection.out_offset) {
+        latencies_us_.push_back(std::chrono::duration<double, std::micro>(now - connection.unsent.front().arrived).count());
+        connection.unsent.pop_front();
+    }
+    if (connection.out_offset == connection.out.size() || connection.broken) {
+        connection.out.clear();
+        connection.out_offset = 0;
+        connection.unsent.clear();
+    }
+}
+
+void InferenceServer::run_batch() {
+    const std::size_t width = network_.input_size();
+    const std::size_t classes = network_.output_size();
+    const std::size_t rows = std::min(config_.max_batch, pending_.size());
+
+    batch_.resize(rows, width);
+    for (std::size_t r = 0; r < rows; ++r) {
+        DataProcessor::normalize_pixels(pending_[r].pixels.data(), batch_.data() + r * width, width);
+    }
+    const Tensor2D<float>& logits = network_.forward(batch_, buffers_);
+    Span<float> probabilities(probabilities_.data(), rows * classes);
+    Activations::softmax<float>(logits.flat(), probabilities, classes);
+
+    for (std::size_t r = 0; r < rows; ++r) {
+        Connection& connection = connections_[pending_.front().connection];
+        --connection.in_flight;
+        if (!connection.broken) {
+            const float* p = probabilities.data() + r * classes;
+            uint32_t predicted = static_cast<uint32_t>(std::max_element(p, p + classes) - p);
+            const unsigned char* head = reinterpret_cast<const unsigned char*>(&predicted);
+            const unsigned char* body = reinterpret_cast<const unsigned char*>(p);
+            connection.out.insert(connection.out.end(), head, head + sizeof(predicted));
+            connection.out.insert(connection.out.end(), body, body + classes * sizeof(float));
+            connection.unsent.push_back(Unsent{connection.out.size(), pending_.front().arrived});
+        }
+        pending_.pop_front();
+    }
+    // One write per connection for the whole batch
+    for (Connection& connection : connections_) {
+        if (connection.fd >= 0 && !connection.out.empty()) {
+            flush_client(connection);
+        }
+    }
+    ++batches_;
+}
+
+// A connection is done once it has failed, or once its peer has stopped sending and every
+// response has been written
+void InferenceServer::release_closed() {
+    for (Connection& connection : connections_) {
+        if (connection.fd >= 0 && connection.in_flight == 0 &&
+            (connection.broken || (connection.eof && connection.out.empty()))) {
+            ::close(connection.fd);
+            connection.fd = -1;
+            connection.in.clear();
+            connection.out.clear();
+            connection.out_offset = 0;
+            connection.unsent.clear();
+        }
+    }
+}
+
+void InferenceServer::run() {
+    const std::chrono::microseconds max_wait(config_.max_wait_us);
+    std::vector<pollfd> fds;
+    std::vector<std::size_t> slots; // fds[i + 1] belongs to connections_[slots[i]]
+    Clock::time_point last_report = Clock::now();
+
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        fds.clear();
+        slots.clear();
+        fds.push_back(pollfd{listen_fd_, POLLIN, 0});
+        for (std::size_t i = 0; i < connections_.size(); ++i) {
+            const Connection& connection = connections_[i];
+            if (connection.fd >= 0 && !connection.broken) {
+                // A connection over its backpressure limits is only polled for errors and POLLOUT
+                short events = (wants_input(connection) ? POLLIN : 0) | (connection.out.empty() ? 0 : POLLOUT);
+                fds.push_back(pollfd{connection.fd, events, 0});
+                slots.push_back(i);
+            }
+        }
+
+        // Sleep until input arrives or the oldest pending request reaches its deadline;
+        // wake up periodically otherwise to notice stop()
+        timespec timeout = {0, 100 * 1000 * 1000};
+        if (!pending_.empty()) {
+            Clock::duration left = pending_.front().arrived + max_wait - Clock::now();
+            long long ns = std::max<long long>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(left).count());
+            timeout.tv_sec = static_cast<time_t>(ns / 1000000000);
+            timeout.tv_nsec = static_cast<long>(ns % 1000000000);
+        }
+        int ready = ::ppoll(fds.data(), fds.size(), &timeout, nullptr);
+        if (ready < 0 && errno != EINTR) {
+            throw std::runtime_error(std::string("InferenceServer: poll failed: ") + std::strerror(errno));
+        }
+
+        if (ready > 0) {
+            for (std::size_t i = 1; i < fds.size(); ++i) {
+                Connection& connection = connections_[slots[i - 1]];
+                if (fds[i].revents & POLLERR) {
+                    connection.broken = true;
+                } else if ((fds[i].revents & POLLHUP) && connection.eof) {
+                    connection.broken = true; // Both directions are gone; nothing more can be delivered
+                } else if (fds[i].revents & (POLLIN | POLLHUP)) {
+                    read_client(slots[i - 1]);
+                }
+                if ((fds[i].revents & POLLOUT) && !connection.broken) {
+                    flush_client(connection);
+                }
+            }
+            if (fds[0].revents & POLLIN) {
+                accept_clients();
+            }
+        }
+
+        // Full batches go immediately; a partial batch goes once its oldest request is due
+        while (pending_.size() >= config_.max_batch ||
+               (!pending_.empty() && Clock::now() - pending_.front().arrived >= max_wait)) {
+            run_batch();
+        }
+        release_closed();
+
+        if (config_.report_interval_s > 0.0 &&
+            std::chrono::duration<double>(Clock::now() - last_report).count() >= config_.report_interval_s) {
+            last_report = Clock::now();
+            if (!latencies_us_.empty()) {
+                print_server_stats(std::cout, take_stats());
+            }
+        }
+    }
+}
+
+ServerStats InferenceServer::take_stats() {
+    ServerStats stats;
+    Clock::time_point now = Clock::now();
+    stats.requests = latencies_us_.size();
+    stats.batches = batches_;
+    stats.seconds = std::chrono::duration<double>(now - stats_start_).count();
+    if (stats.seconds > 0.0) {
+        stats.requests_per_second = static_cast<double>(stats.requests) / stats.seconds;
+    }
+    if (stats.batches > 0) {
+        stats.mean_batch = static_cast<double>(stats.requests) / static_cast<double>(stats.batches);
+    }
+    std::sort(latencies_us_.begin(), latencies_us_.end());
+    stats.p50_us = percentile(latencies_us_, 0.50);
+    stats.p99_us = percentile(latencies_us_, 0.99);
+
+    latencies_us_.clear();
+    batches_ = 0;
+    stats_start_ = now;
+    return stats;
+}
@@ -0,0 +1,120 @@
+#ifndef INFERENCE_SERVER_H
+#define INFERENCE_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "neural_network.h"
+#include "tensor.h"
+
+// Wire protocol, per connection, in host byte order (the socket is local):
+//   request:  input_size() raw pixels, IDX layout (row-major u8, 784 bytes for MNIST)
+//   response: uint32 predicted class, then output_size() float32 softmax probabilities
+// A client may pipeline several requests; responses come back in request order. A client
+// that shuts down its write side still receives the responses to everything it sent.
+struct InferenceServerConfig {
+    std::string socket_path = "/tmp/mnist.sock";
+    std::size_t max_batch = 32;  // Run as soon as this many requests are pending
+    std::size_t max_wait_us = 500; // ... or when the oldest pending request has waited this long
+    // Backpressure: a connection is not read while it has this many requests queued ...
+    std::size_t max_in_flight = 256;
+    // ... or this many response bytes it has not yet taken
+    std::size_t max_unsent_bytes = 1 << 20;
+    double report_interval_s = 0.0; // > 0: print serving metrics to stdout this often while busy
+};
+
+// Serving metrics over an interval
+struct ServerStats {
+    std::size_t requests = 0;
+    std::size_t batches = 0;
+    double seconds = 0.0;
+    double requests_per_second = 0.0;
+    double mean_batch = 0.0;
+    double p50_us = 0.0; // Latency from a request's last byte arriving to its response being sent
+    double p99_us = 0.0;
+};
+
+// One line: requests, req/s, mean batch size, p50/p99 latency
+void print_server_stats(std::ostream& out, const ServerStats& stats);
+
+// Long-running scoring daemon on a Unix domain socket.
+// A single event-loop thread polls the listening socket and every client, assembles
+// complete requests, and coalesces requests from all connections into micro-batches
+// that run through one forward pass, so concurrent clients share each GEMM.
+class InferenceServer {
+public:
+    // Binds and listens on config.socket_path (an existing socket file there is replaced).
+    // The network must outlive the server. Throws std::invalid_argument for an empty network or a
+    // zero max_batch, max_in_flight or max_unsent_bytes, std::runtime_error if the socket cannot be set up.
+    InferenceServer(const NeuralNetwork& network, const InferenceServerConfig& config);
+    ~InferenceServer();
+
+    InferenceServer(const InferenceServer&) = delete;
+    InferenceServer& operator=(const InferenceServer&) = delete;
+
+    // Serves until stop() is called (from any thread or a signal handler)
+    void run();
+    void stop() { stopping_.store(true, std::memory_order_relaxed); }
+
+    // Metrics since the previous call (or startup), then resets them. Call from the run() thread
+    // or after run() returns.
+    ServerStats take_stats();
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    // A response in Connection::out; its latency is recorded once out_offset passes end
+    struct Unsent {
+        std::size_t end;
+        Clock::time_point arrived;
+    };
+
+    // Connection slots are reused rather than erased, so pending requests can refer to them
+    // by index. A slot is free when fd < 0.
+    struct Connection {
+        int fd = -1;
+        std::vector<unsigned char> in;  // Partial request bytes
+        std::vector<unsigned char> out; // Response bytes not yet written
+        std::size_t out_offset = 0;
+        std::deque<Unsent> unsent;
+        std::size_t in_flight = 0;      // Requests queued in pending_
+        bool eof = false;               // Peer shut down its write side; queued requests are still answered
+        bool broken = false;            // Socket error; responses are dropped
+    };
+
+    struct Pending {
+        std::size_t connection; // Slot in connections_
+        Clock::time_point arrived;
+        std::vector<unsigned char> pixels;
+    };
+
+    void accept_clients();
+    void read_client(std::size_t index);
+    bool wants_input(const Connection& connection) const;
+    void flush_client(Connection& connection);
+    void run_batch();
+    void release_closed();
+
+    const NeuralNetwork& network_;
+    InferenceServerConfig config_;
+    int listen_fd_;
+    std::atomic<bool> stopping_;
+    std::vector<Connection> connections_;
+    std::deque<Pending> pending_;
+
+    Batch batch_;
+    PassBuffers buffers_;
+    std::vector<float> probabilities_;
+
+    std::vector<double> latencies_us_;
+    std::size_t batches_;
+    Clock::time_point stats_start_;
+};
+
+#endif // INFERENCE_SERVER_H
@@ -0,0 +1,154 @@
+#include "layer.h"
+#include "gemm.h"
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+// Y = f(Z) in place
+template <typename T>
+void activate(Activations::Kind activation, Span<T> y) {
+    switch (activation) {
+        case Activations::Kind::Identity: break;
+        case Activations::Kind::Sigmoid: Activations::sigmoid<T>(y, y); break;
+        case Activations::Kind::ReLU: Activations::relu<T>(y, y); break;
+        case Activations::Kind::Tanh: Activations::tanh_activation<T>(y, y); break;
+    }
+}
+
+// dZ = dY * f'(.) in place. For ReLU, y > 0 exactly when x > 0, so the output doubles as the mask.
+template <typename T>
+void activation_backward(Activations::Kind activation, Span<const T> output, Span<T> dz) {
+    switch (activation) {
+        case Activations::Kind::Identity: break;
+        case Activations::Kind::Sigmoid: Activations::sigmoid_backward<T>(output, dz); break;
+        case Activations::Kind::ReLU: Activations::relu_backward<T>(output, dz); break;
+        case Activations::Kind::Tanh: Activations::tanh_backward<T>(output, dz); break;
+    }
+}
+
+template <typename T>
+void seed_with_bias(const T* biases, std::size_t batch, std::size_t outputs, T* out) {
+    for (std::size_t r = 0; r < batch; ++r) {
+        std::copy(biases, biases + outputs, out + r * outputs);
+    }
+}
+
+// db += column sums of dZ
+template <typename T>
+void add_bias_gradient(const Tensor2D<T>& dz, T* db) {
+    for (std::size_t r = 0; r < dz.rows(); ++r) {
+        const T* row = dz.data() + r * dz.cols();
+        for (std::size_t c = 0; c < dz.cols(); ++c) {
+            db[c] += row[c];
+        }
+    }
+}
+
+} // namespace
+
+template <typename T>
+BasicDenseLayer<T>::BasicDenseLayer() : activation_(Activations::Kind::Identity) {
+}
+
+template <typename T>
+BasicDenseLayer<T>::BasicDenseLayer(std::size_t inputs, std::size_t outputs, Activations::Kind activation, uint32_t seed)
+    : weights_(inputs, outputs), biases_(1, outputs), activation_(activation) {
+    if (inputs == 0 || outputs == 0) {
+        throw std::invalid_argument("DenseLayer: inputs and outputs must be non-zero.");
+    }
+    // He init keeps ReLU activations from shrinking layer to layer; Xavier suits saturating functions.
+    double fan = (activation == Activations::Kind::ReLU) ? 6.0 / inputs : 6.0 / (inputs + outputs);
+    float limit = static_cast<float>(std::sqrt(fan));
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-limit, limit);
+    for (std::size_t i = 0; i < weights_.size(); ++i) {
+        weights_.data()[i] = static_cast<T>(dist(rng));
+    }
+}
+
+template <typename T>
+void dense_forward(const T* weights, const T* biases,
+                   std::size_t inputs, std::size_t outputs, Activations::Kind activation,
+                   const Tensor2D<T>& input, Tensor2D<T>& output) {
+    if (input.cols() != inputs) {
+        throw std::invalid_argument("DenseLayer::forward: input width does not match layer inputs.");
+    }
+    std::size_t batch = input.rows();
+    output.resize(batch, outputs);
+
+    // Seed the output with the bias row, then accumulate X * W on top of it
+    seed_with_bias(biases, batch, outputs, output.data());
+    Gemm::gemm(false, false, batch, outputs, inputs, T(1),
+               input.data(), inputs, weights, outputs, T(1),
+               output.data(), outputs);
+    activate(activation, output.flat());
+}
+
+template <typename T>
+void BasicDenseLayer<T>::forward(const Tensor2D<T>& input, Tensor2D<T>& output) const {
+    dense_forward(weights_.data(), biases_.data(), inputs(), outputs(), activation_, input, output);
+}
+
+template <typename T>
+void BasicDenseLayer<T>::forward(const BasicSparseBatch<T>& input, Tensor2D<T>& output) const {
+    if (input.cols() != inputs()) {
+        throw std::invalid_argument("DenseLayer::forward: input width does not match layer inputs.");
+    }
+    output.resize(input.rows(), outputs());
+    seed_with_bias(biases_.data(), input.rows(), outputs(), output.data());
+    Sparse::csr_gemm(input, weights_.data(), outputs(), output.data());
+    activate(activation_, output.flat());
+}
+
+template <typename T>
+void BasicDenseLayer<T>::backward(const Tensor2D<T>& input,
+                                  const Tensor2D<T>& output,
+                                  Tensor2D<T>& grad_output,
+                                  Tensor2D<T>* grad_input,
+                                  BasicLayerGradients<T>& grads) const {
+    std::size_t batch = input.rows();
+    if (grad_output.rows() != batch || grad_output.cols() != outputs() || output.size() != grad_output.size()) {
+        throw std::invalid_argument("DenseLayer::backward: gradient shape does not match the forward batch.");
+    }
+
+    activation_backward(activation_, output.flat(), grad_output.flat());
+
+    // dW += X^T dZ
+    Gemm::gemm(true, false, inputs(), outputs(), batch, T(1),
+               input.data(), inputs(), grad_output.data(), outputs(), T(1),
+               grads.weights.data(), outputs());
+    add_bias_gradient(grad_output, grads.biases.data());
+
+    // dX = dZ W^T
+    if (grad_input != nullptr) {
+        grad_input->resize(batch, inputs());
+        Gemm::gemm(false, true, batch, inputs(), outputs(), T(1),
+                   grad_output.data(), outputs(), weights_.data(), outputs(), T(0),
+                   grad_input->data(), inputs());
+    }
+}
+
+template <typename T>
+void BasicDenseLayer<T>::backward(const BasicSparseBatch<T>& input,
+                                  const Tensor2D<T>& output,
+                                  Tensor2D<T>& grad_output,
+                                  BasicLayerGradients<T>& grads) const {
+    if (grad_output.rows() != input.rows() || grad_output.cols() != outputs() || output.size() != grad_output.size()) {
+        throw std::invalid_argument("DenseLayer::backward: gradient shape does not match the forward batch.");
+    }
+    activation_backward(activation_, output.flat(), grad_output.flat());
+
+    // dW += X^T dZ over the nonzero rows of X only
+    Sparse::csr_gemm_tn(input, grad_output.data(), outputs(), grads.weights.data());
+    add_bias_gradient(grad_output, grads.biases.data());
+}
+
+template void dense_forward<float>(const float*, const float*, std::size_t, std::size_t, Activations::Kind,
+                                   const Tensor2D<float>&, Tensor2D<float>&);
+template void dense_forward<double>(const double*, const double*, std::size_t, std::size_t, Activations::Kind,
+                                    const Tensor2D<double>&, Tensor2D<double>&);
+template class BasicDenseLayer<float>;
+template class BasicDenseLayer<double>;
@@ -0,0 +1,110 @@
+#ifndef LAYER_H
+#define LAYER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "activation_functions.h"
+#include "sparse_batch.h"
+#include "tensor.h"
+
+// Layers, networks and optimizers are templated on the scalar type T and instantiated
+// for float and double. float is the fast path everything else uses (via the
+// DenseLayer / LayerGradients aliases below); double exists for gradient checks and
+// numerical validation.
+
+// Gradients of one DenseLayer's parameters. Kept outside the layer so several
+// threads can each accumulate into their own copy while sharing the weights.
+template <typename T>
+struct BasicLayerGradients {
+    Tensor2D<T> weights; // inputs x outputs
+    Tensor2D<T> biases;  // 1 x outputs
+
+    BasicLayerGradients() {}
+    BasicLayerGradients(std::size_t inputs, std::size_t outputs) : weights(inputs, outputs), biases(1, outputs) {}
+
+    void zero() {
+        weights.fill(T(0));
+        biases.fill(T(0));
+    }
+};
+
+/**
+ * @brief Dense forward pass over raw parameter pointers: output = f(input * W + b).
+ * Shared by DenseLayer and by models whose weights live elsewhere (e.g. a mapped checkpoint).
+ * @param weights inputs x outputs, row-major.
+ * @param biases outputs values.
+ * @param output Resized to input.rows() x outputs.
+ */
+template <typename T>
+void dense_forward(const T* weights, const T* biases,
+                   std::size_t inputs, std::size_t outputs, Activations::Kind activation,
+                   const Tensor2D<T>& input, Tensor2D<T>& output);
+
+// Fully connected layer operating on whole mini-batches: Y = f(X W + b).
+// All products go through Gemm::gemm (sgemm for float, dgemm for double), so there is no
+// per-neuron object model; a layer is just a weight matrix, a bias row and an activation kind.
+template <typename T>
+class BasicDenseLayer {
+public:
+    BasicDenseLayer();
+
+    // Weights use He (ReLU) or Xavier (others) uniform initialization from `seed`; biases start at 0.
+    // The draws are made in float, so float and double layers with the same seed start equal.
+    BasicDenseLayer(std::size_t inputs, std::size_t outputs, Activations::Kind activation, uint32_t seed);
+
+    std::size_t inputs() const { return weights_.rows(); }
+    std::size_t outputs() const { return weights_.cols(); }
+    Activations::Kind activation() const { return activation_; }
+
+    Tensor2D<T>& weights() { return weights_; }
+    const Tensor2D<T>& weights() const { return weights_; }
+    Tensor2D<T>& biases() { return biases_; }
+    const Tensor2D<T>& biases() const { return biases_; }
+
+    /**
+     * @brief Forward pass for a batch.
+     * @param input B x inputs().
+     * @param output Resized to B x outputs(); receives f(input * W + b).
+     */
+    void forward(const Tensor2D<T>& input, Tensor2D<T>& output) const;
+
+    /**
+     * @brief Forward pass for a sparse batch (input layer only): reads only the weight
+     * rows of nonzero inputs. Same result as forward() on input.to_dense().
+     */
+    void forward(const BasicSparseBatch<T>& input, Tensor2D<T>& output) const;
+
+    /**
+     * @brief Backward pass for a batch.
+     * @param input The batch given to forward().
+     * @param output The activated output forward() produced.
+     * @param grad_output dL/dY on entry; overwritten with dL/dZ (pre-activation gradient).
+     * @param grad_input If non-null, resized and filled with dL/dX = dZ * W^T.
+     * @param grads dW = X^T dZ and db = column sums of dZ are *added* to these.
+     */
+    void backward(const Tensor2D<T>& input,
+                  const Tensor2D<T>& output,
+                  Tensor2D<T>& grad_output,
+                  Tensor2D<T>* grad_input,
+                  BasicLayerGradients<T>& grads) const;
+
+    /**
+     * @brief Backward pass for a sparse batch given to forward(). dW only gains rows for
+     * the nonzero inputs; dL/dX is not produced since a sparse batch only feeds the input layer.
+     */
+    void backward(const BasicSparseBatch<T>& input,
+                  const Tensor2D<T>& output,
+                  Tensor2D<T>& grad_output,
+                  BasicLayerGradients<T>& grads) const;
+
+private:
+    Tensor2D<T> weights_; // inputs x outputs, so forward is a plain X * W
+    Tensor2D<T> biases_;  // 1 x outputs
+    Activations::Kind activation_;
+};
+
+typedef BasicLayerGradients<float> LayerGradients;
+typedef BasicDenseLayer<float> DenseLayer;
+
+#endif // LAYER_H
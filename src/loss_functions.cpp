@@ -1,8 +1,10 @@
 #include "loss_functions.h"
+#include "activation_functions.h"
 #include <stdexcept>   // For std::invalid_argument, std::out_of_range
 #include <numeric>     // For std::accumulate (if needed, not used here)
 #include <vector>
 #include <cmath>       // For std::log, std::pow, std::max, std::min
+#include <algorithm>   // For std::max_element
 
 namespace LossFunctions {
 
@@ -32,11 +34,19 @@ namespace LossFunctions {
         }
 
         std::vector<double> derivatives(predictions.size());
+        mean_squared_error_derivative(predictions, targets, derivatives);
+        return derivatives;
+    }
+
+    void mean_squared_error_derivative(Span<const double> predictions, Span<const double> targets,
+                                       Span<double> derivatives) {
+        if (predictions.size() != targets.size() || derivatives.size() != predictions.size()) {
+            throw std::invalid_argument("MSE Derivative: Predictions, targets and output spans must have the same size.");
+        }
         double N = static_cast<double>(predictions.size());
         for (size_t i = 0; i < predictions.size(); ++i) {
             derivatives[i] = (2.0 / N) * (predictions[i] - targets[i]);
         }
-        return derivatives;
     }
 
     // --- Categorical Cross-Entropy Loss ---
@@ -92,11 +102,20 @@ namespace LossFunctions {
         }
 
         std::vector<double> derivatives(predictions.size());
+        categorical_cross_entropy_softmax_derivative(predictions, targets_one_hot, derivatives);
+        return derivatives;
+    }
+
+    void categorical_cross_entropy_softmax_derivative(Span<const double> predictions,
+                                                      Span<const double> targets_one_hot,
+                                                      Span<double> derivatives) {
+        if (predictions.size() != targets_one_hot.size() || derivatives.size() != predictions.size()) {
+            throw std::invalid_argument("Cross-Entropy Derivative: Predictions, targets_one_hot and output spans must have the same size.");
+        }
         for (size_t i = 0; i < predictions.size(); ++i) {
             // dL/dz_i = p_i - y_i
             derivatives[i] = predictions[i] - targets_one_hot[i];
         }
-        return derivatives;
     }
 
     std::vector<double> categorical_cross_entropy_softmax_derivative_with_index(
@@ -112,12 +131,85 @@ namespace LossFunctions {
         }
 
         std::vector<double> derivatives(num_classes);
+        categorical_cross_entropy_softmax_derivative_with_index(predictions, true_class_index, derivatives);
+        return derivatives;
+    }
+
+    void categorical_cross_entropy_softmax_derivative_with_index(Span<const double> predictions,
+                                                                 int true_class_index,
+                                                                 Span<double> derivatives) {
+        int num_classes = static_cast<int>(predictions.size());
+        if (true_class_index < 0 || true_class_index >= num_classes) {
+            throw std::out_of_range("Cross-Entropy Derivative (index): true_class_index is out of bounds for predictions vector size.");
+        }
+        if (derivatives.size() != predictions.size()) {
+            throw std::invalid_argument("Cross-Entropy Derivative (index): Output span must match predictions in size.");
+        }
         for (int i = 0; i < num_classes; ++i) {
             double target_val_yi = (i == true_class_index) ? 1.0 : 0.0;
             // dL/dz_i = p_i - y_i
             derivatives[i] = predictions[i] - target_val_yi;
         }
-        return derivatives;
     }
 
+    // --- Fused Softmax + Cross-Entropy over a mini-batch ---
+    template <typename T>
+    double softmax_cross_entropy(ConstSpan<T> logits,
+                                 Span<const unsigned char> labels,
+                                 Span<T> grad_out,
+                                 std::size_t num_classes) {
+        std::size_t batch_size = labels.size();
+        if (num_classes == 0 || logits.size() != batch_size * num_classes) {
+            throw std::invalid_argument("Softmax Cross-Entropy: logits must be labels.size() x num_classes.");
+        }
+        if (grad_out.size() != logits.size()) {
+            throw std::invalid_argument("Softmax Cross-Entropy: grad_out must be the same size as logits.");
+        }
+        if (batch_size == 0) {
+            return 0.0;
+        }
+
+        // Checked up front so a bad label leaves grad_out (and an aliased logits) untouched
+        for (std::size_t b = 0; b < batch_size; ++b) {
+            if (labels[b] >= num_classes) {
+                throw std::out_of_range("Softmax Cross-Entropy: label is out of bounds for num_classes.");
+            }
+        }
+
+        const T inv_batch = T(1) / static_cast<T>(batch_size);
+        double total_loss = 0.0;
+        for (std::size_t b = 0; b < batch_size; ++b) {
+            std::size_t label = labels[b];
+            // Each row is read from memory once; the passes below stay in L1.
+            const T* z = logits.data() + b * num_classes;
+            T* g = grad_out.data() + b * num_classes;
+
+            T max_z = *std::max_element(z, z + num_classes);
+            T z_label = z[label]; // Read before g overwrites it when aliased
+            for (std::size_t i = 0; i < num_classes; ++i) {
+                g[i] = z[i] - max_z;
+            }
+            // Honors Activations::Precision, so Fast mode shares the approximate exp
+            Activations::exponential<T>(ConstSpan<T>(g, num_classes), Span<T>(g, num_classes));
+            T sum = T(0);
+            for (std::size_t i = 0; i < num_classes; ++i) {
+                sum += g[i];
+            }
+
+            // -log(p_label) = log(sum) - (z_label - max_z)
+            total_loss += static_cast<double>(std::log(sum) - (z_label - max_z));
+
+            // dL/dz_i = (p_i - y_i) / B
+            T scale = inv_batch / sum;
+            for (std::size_t i = 0; i < num_classes; ++i) {
+                g[i] *= scale;
+            }
+            g[label] -= inv_batch;
+        }
+        return total_loss / static_cast<double>(batch_size);
+    }
+
+    template double softmax_cross_entropy<float>(ConstSpan<float>, Span<const unsigned char>, Span<float>, std::size_t);
+    template double softmax_cross_entropy<double>(ConstSpan<double>, Span<const unsigned char>, Span<double>, std::size_t);
+
 } // namespace LossFunctions
\ No newline at end of file
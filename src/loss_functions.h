@@ -4,6 +4,9 @@
 #include <vector>
 #include <cmath>       // For std::log, std::pow, std::max
 #include <stdexcept>   // For exceptions
+#include <cstddef>
+
+#include "span.h"
 
 // Using double for precision.
 namespace LossFunctions {
@@ -29,6 +32,14 @@ namespace LossFunctions {
      */
     std::vector<double> mean_squared_error_derivative(const std::vector<double>& predictions, const std::vector<double>& targets);
 
+    /**
+     * @brief As above, writing into a caller-provided buffer (e.g. a Workspace slice) instead of
+     * returning a new vector.
+     * @param derivatives predictions.size() outputs.
+     */
+    void mean_squared_error_derivative(Span<const double> predictions, Span<const double> targets,
+                                       Span<double> derivatives);
+
 
     // --- Categorical Cross-Entropy Loss ---
     // Typically used with a Softmax output layer.
@@ -71,6 +82,14 @@ namespace LossFunctions {
         const std::vector<double>& predictions,
         const std::vector<double>& targets_one_hot);
 
+    /**
+     * @brief As above, writing into a caller-provided buffer instead of returning a new vector.
+     * @param derivatives predictions.size() outputs.
+     */
+    void categorical_cross_entropy_softmax_derivative(Span<const double> predictions,
+                                                      Span<const double> targets_one_hot,
+                                                      Span<double> derivatives);
+
     /**
      * @brief Calculates the derivative of Categorical Cross-Entropy loss with respect to
      * the pre-softmax logits (z_i), assuming predictions are the output of a Softmax layer,
@@ -84,6 +103,37 @@ namespace LossFunctions {
         const std::vector<double>& predictions,
         int true_class_index);
 
+    /**
+     * @brief As above, writing into a caller-provided buffer instead of returning a new vector.
+     * @param derivatives predictions.size() outputs.
+     */
+    void categorical_cross_entropy_softmax_derivative_with_index(Span<const double> predictions,
+                                                                 int true_class_index,
+                                                                 Span<double> derivatives);
+
+
+    // --- Fused Softmax + Cross-Entropy over a mini-batch ---
+
+    /**
+     * @brief Softmax followed by Categorical Cross-Entropy for a whole batch, in one kernel.
+     * Uses log-sum-exp, so large logits do not overflow:
+     * L_b = log(sum_j exp(z_bj - m_b)) + m_b - z_b[label_b], with m_b = max_j z_bj.
+     * Writes the gradient of the *mean* loss with respect to the logits into grad_out:
+     * grad_out[b][i] = (softmax(z_b)_i - y_bi) / B. No memory is allocated.
+     * Works for T = float or double; the loss is accumulated in double.
+     * @param logits Row-major B x C pre-softmax scores.
+     * @param labels B true class indices, each in [0, C).
+     * @param grad_out Caller-provided B x C buffer (may alias logits).
+     * @param num_classes C, the number of classes per row.
+     * @return The mean cross-entropy loss over the batch.
+     * Throws std::out_of_range for a label >= C before anything is written.
+     */
+    template <typename T>
+    double softmax_cross_entropy(ConstSpan<T> logits,
+                                 Span<const unsigned char> labels,
+                                 Span<T> grad_out,
+                                 std::size_t num_classes);
+
 } // namespace LossFunctions
 
 #endif // LOSS_FUNCTIONS_H
\ No newline at end of file
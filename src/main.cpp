@@ -1,53 +1,160 @@
+#include "activation_functions.h"
 #include "mnist_reader.h"
-#include "data_processor.h" // 
+#include "data_loader.h"
+#include "dataset_cache.h"
+#include "evaluator.h"
+#include "neural_network.h"
+#include "checkpoint.h"
+#include "optimizer.h"
+#include "profiler.h"
+#include "trainer.h"
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 #include <iomanip> 
+#include <cstdlib>
 
 int main() {
     try {
+        // Set DNN_TRACE_FILE to record a Chrome trace (chrome://tracing) of the whole run
+        const char* trace_path = std::getenv("DNN_TRACE_FILE");
+        if (trace_path != nullptr) {
+            Profiler::start_trace();
+        }
+
+        // Set DNN_FAST_MATH=1 to use the approximate exp/sigmoid/tanh kernels (see
+        // Activations::Precision for their error bounds)
+        const char* fast_math = std::getenv("DNN_FAST_MATH");
+        if (fast_math != nullptr && std::string(fast_math) != "0") {
+            Activations::set_precision(Activations::Precision::Fast);
+            std::cout << "Using fast approximate activations." << std::endl;
+        }
+
         std::string train_images_path = "../data/train-images-idx3-ubyte/train-images-idx3-ubyte";
         std::string train_labels_path = "../data/train-labels-idx1-ubyte/train-labels-idx1-ubyte";
         std::string test_images_path = "../data/t10k-images-idx3-ubyte/t10k-images-idx3-ubyte";
         std::string test_labels_path = "../data/t10k-labels-idx1-ubyte/t10k-labels-idx1-ubyte";
 
+        // Set DNN_MEMORY_CAP_MB to stream the training set in bounded memory instead of
+        // mapping it, e.g. for generated IDX files larger than RAM
+        const char* memory_cap_mb = std::getenv("DNN_MEMORY_CAP_MB");
+        // Set DNN_DATASET_CACHE to a file path to keep the normalized training set there:
+        // later runs map it instead of re-reading and normalizing the IDX files
+        const char* cache_path = std::getenv("DNN_DATASET_CACHE");
+        const int epochs = 5;
+        DataLoaderConfig loader_config;
+        loader_config.batch_size = 64;
+        loader_config.epochs = epochs;
+        // MNIST pixels are ~80% zeros, so batches go out in CSR form and the input layer
+        // skips the zero pixels (it falls back to the dense path for dense batches).
+        // Set DNN_DENSE_INPUT=1 to feed dense batches instead.
+        const char* dense_input = std::getenv("DNN_DENSE_INPUT");
+        loader_config.sparse = (dense_input == nullptr || std::string(dense_input) == "0");
+        // Set DNN_AUGMENT to a thread count to train on randomly distorted training images,
+        // redrawn every epoch by that many loader-side threads. Distortion needs the raw
+        // pixels, so it bypasses DNN_DATASET_CACHE.
+        const char* augment_threads = std::getenv("DNN_AUGMENT");
+        if (augment_threads != nullptr && std::string(augment_threads) != "0") {
+            loader_config.augment = true;
+            loader_config.augment_threads = std::stoull(augment_threads);
+        }
+
         // --- 1. Read Raw Data ---
         std::cout << "--- Reading Raw Data ---" << std::endl;
-        std::cout << "Attempting to read training images from: " << train_images_path << std::endl;
-        std::vector<std::vector<unsigned char>> raw_train_images = read_mnist_images(train_images_path);
-        std::cout << "Successfully read " << raw_train_images.size() << " raw training images." << std::endl;
+        std::unique_ptr<MnistImageView> raw_train_images;
+        std::vector<unsigned char> raw_train_labels;
+        std::unique_ptr<DatasetCache> train_cache;
+        if (cache_path != nullptr && memory_cap_mb == nullptr && !loader_config.augment) {
+            train_cache.reset(new DatasetCache(cache_path, train_images_path, train_labels_path));
+            std::cout << (train_cache->rebuilt() ? "Rebuilt" : "Loaded") << " dataset cache " << cache_path << ": "
+                      << train_cache->count() << " preprocessed training images." << std::endl;
+        } else if (memory_cap_mb == nullptr) {
+            std::cout << "Attempting to read training images from: " << train_images_path << std::endl;
+            // Memory-mapped: the raw pixels are never copied onto the heap
+            raw_train_images.reset(new MnistImageView(train_images_path));
+            std::cout << "Successfully read " << raw_train_images->count() << " raw training images." << std::endl;
 
-        std::cout << "Attempting to read training labels from: " << train_labels_path << std::endl;
-        std::vector<unsigned char> raw_train_labels = read_mnist_labels(train_labels_path);
-        std::cout << "Successfully read " << raw_train_labels.size() << " raw training labels." << std::endl;
+            std::cout << "Attempting to read training labels from: " << train_labels_path << std::endl;
+            raw_train_labels = read_mnist_labels(train_labels_path);
+            std::cout << "Successfully read " << raw_train_labels.size() << " raw training labels." << std::endl;
+        } else {
+            loader_config.memory_cap = std::stoull(memory_cap_mb) << 20;
+            std::cout << "Streaming training data from " << train_images_path << " within "
+                      << memory_cap_mb << " MiB." << std::endl;
+        }
+
+        std::cout << "Attempting to read test images from: " << test_images_path << std::endl;
+        MnistImageView test_images(test_images_path);
+        std::vector<unsigned char> test_labels = read_mnist_labels(test_labels_path);
+        std::cout << "Successfully read " << test_images.count() << " test images and " << test_labels.size()
+                  << " labels." << std::endl;
 
         // --- 2. Process Data ---
+        // Batches are shuffled, gathered and normalized on a background thread while the
+        // previous batch trains, so the full float dataset is never materialized.
         std::cout << "\n--- Processing Data ---" << std::endl;
-        DataProcessor processor;
-
-        std::cout << "Processing training images (normalizing to 0.0-1.0)..." << std::endl;
-        std::vector<std::vector<float>> processed_train_images = processor.process_images(raw_train_images);
-        if (!processed_train_images.empty()) {
-             std::cout << "Successfully processed " << processed_train_images.size() << " training images." << std::endl;
-             if (!processed_train_images[0].empty()){
-                std::cout << "First processed image now has " << processed_train_images[0].size() << " float pixels." << std::endl;
-             }
+        std::unique_ptr<DataLoader> train_loader;
+        if (train_cache) {
+            train_loader.reset(new DataLoader(*train_cache, loader_config));
+        } else if (raw_train_images) {
+            train_loader.reset(new DataLoader(*raw_train_images, raw_train_labels, loader_config));
         } else {
-            std::cout << "Warning: Processed training images vector is empty." << std::endl;
+            train_loader.reset(new DataLoader(train_images_path, train_labels_path, loader_config));
         }
+        std::cout << "Streaming " << train_loader->batches_per_epoch() << " normalized "
+                  << (loader_config.augment ? "augmented " : "") << (loader_config.sparse ? "sparse " : "") << "batches of " << loader_config.batch_size
+                  << " images per epoch." << std::endl;
 
+        // --- 3. Train ---
+        std::cout << "\n--- Training ---" << std::endl;
+        NeuralNetwork network({train_loader->image_size(), 128, 10}, Activations::Kind::ReLU, 42);
+        SgdOptimizer optimizer(0.05f, 0.9f);
+        TrainerConfig config;
+        config.batch_size = loader_config.batch_size;
+        Trainer trainer(network, optimizer, config);
+        std::cout << "Training 784-128-10 network on " << trainer.num_threads() << " thread(s)." << std::endl;
+        EvaluatorConfig eval_config;
+        eval_config.num_threads = trainer.num_threads();
+        eval_config.sparse = loader_config.sparse;
+        Evaluator evaluator(network, eval_config);
+        EvalStats eval;
 
-        std::cout << "Processing training labels (converting to float)..." << std::endl;
-        std::vector<float> processed_train_labels = processor.process_labels(raw_train_labels);
-         if (!processed_train_labels.empty()) {
-            std::cout << "Successfully processed " << processed_train_labels.size() << " training labels." << std::endl;
-        } else {
-            std::cout << "Warning: Processed training labels vector is empty." << std::endl;
+        Profiler::Snapshot epoch_start = Profiler::snapshot();
+        for (int epoch = 1; epoch <= epochs; ++epoch) {
+            EpochStats stats = trainer.train_epoch(*train_loader);
+            Profiler::Snapshot epoch_end = Profiler::snapshot();
+            std::cout << "Epoch " << epoch << "/" << epochs
+                      << ": loss " << std::fixed << std::setprecision(4) << stats.mean_loss
+                      << ", train accuracy " << std::setprecision(2) << stats.accuracy * 100.0 << "%"
+                      << ", " << std::setprecision(0) << stats.samples_per_second << " samples/s"
+                      << ", loader wait " << std::setprecision(1) << stats.loader_wait_seconds * 1e3 << " ms"
+                      << " (" << stats.loader_stalls << " stalls)" << std::endl;
+            Profiler::print_summary(std::cout, epoch_start, epoch_end, stats.samples);
+
+            eval = evaluator.evaluate(test_images, test_labels);
+            std::cout << "  test: loss " << std::setprecision(4) << eval.mean_loss
+                      << ", accuracy " << std::setprecision(2) << eval.accuracy * 100.0 << "%"
+                      << ", " << std::setprecision(0) << eval.images_per_second << " images/s" << std::endl;
+            // Keep evaluation out of the next epoch's profile
+            epoch_start = Profiler::snapshot();
         }
-        
-        std::cout << "\n--- End of Data Loading and Processing ---" << std::endl;
 
+        std::cout << "\n--- Test Set: per-class metrics ---" << std::endl;
+        std::cout << "class  precision  recall  support" << std::endl;
+        for (std::size_t c = 0; c < eval.num_classes; ++c) {
+            std::cout << std::setw(5) << c << std::setw(10) << std::setprecision(2) << eval.precision(c) * 100.0 << "%"
+                      << std::setw(7) << eval.recall(c) * 100.0 << "%" << std::setw(9) << eval.support(c) << std::endl;
+        }
+
+        std::string model_path = "mnist_model.ckpt";
+        Checkpoint::save(network, model_path);
+        std::cout << "Saved model checkpoint to " << model_path << std::endl;
+
+        if (trace_path != nullptr) {
+            Profiler::write_trace(trace_path);
+            std::cout << "Wrote trace to " << trace_path << std::endl;
+        }
 
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
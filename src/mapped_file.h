@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// RAII read-only memory mapping of a whole file.
+// Move-only; the mapping is released when the object is destroyed.
+class MappedFile {
+public:
+    MappedFile();
+    // Maps the file at full_path. Throws std::runtime_error if it cannot be opened or mapped.
+    explicit MappedFile(const std::string& full_path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    const std::string& path() const { return path_; }
+
+private:
+    void release();
+
+    const unsigned char* data_;
+    std::size_t size_;
+    std::string path_;
+};
+
+#endif // MAPPED_FILE_H
@@ -1,85 +1,218 @@
 #include "mnist_reader.h"
-#include <fstream>
+#include "profiler.h"
 #include <vector>
 #include <string>
 #include <stdexcept>
 #include <algorithm> 
+#include <cerrno>
 
-uint32_t reverse_int(uint32_t i) {
-    unsigned char c1, c2, c3, c4;
-    c1 = i & 255;
-    c2 = (i >> 8) & 255;
-    c3 = (i >> 16) & 255;
-    c4 = (i >> 24) & 255;
-    return ((uint32_t)c1 << 24) + ((uint32_t)c2 << 16) + ((uint32_t)c3 << 8) + c4;
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// IDX headers are big-endian. Assembling the value byte by byte works on any host,
+// so no separate byte-swap step is needed.
+uint32_t read_be_u32(const unsigned char* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
 }
 
-std::vector<std::vector<unsigned char>> read_mnist_images(const std::string& full_path) {
-    std::ifstream file(full_path, std::ios::binary);
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open file: " + full_path);
+const std::size_t kImageHeaderSize = 16; // magic, count, rows, cols
+const std::size_t kLabelHeaderSize = 8;  // magic, count
+
+// count * rows * cols, or false if a hostile header makes it overflow
+bool pixel_bytes(std::size_t count, std::size_t rows, std::size_t cols, std::size_t& bytes) {
+    std::size_t image_size;
+    return !__builtin_mul_overflow(rows, cols, &image_size) && !__builtin_mul_overflow(count, image_size, &bytes);
+}
+
+// Reads exactly `size` bytes at `offset`, retrying short reads and EINTR
+void pread_fully(int fd, unsigned char* dst, std::size_t size, std::size_t offset, const std::string& path) {
+    while (size > 0) {
+        ssize_t got = ::pread(fd, dst, size, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            throw std::runtime_error("Error reading data from file or unexpected EOF: " + path);
+        }
+        dst += got;
+        size -= static_cast<std::size_t>(got);
+        offset += static_cast<std::size_t>(got);
     }
+}
 
-    uint32_t magic_number = 0;
-    uint32_t num_images = 0;
-    uint32_t num_rows = 0;
-    uint32_t num_cols = 0;
+std::size_t file_size(int fd, const std::string& path) {
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        throw std::runtime_error("Cannot stat file: " + path);
+    }
+    return static_cast<std::size_t>(st.st_size);
+}
 
-    file.read(reinterpret_cast<char*>(&magic_number), sizeof(magic_number));
-    magic_number = reverse_int(magic_number);
-    if (magic_number != 2051) { // Magic number for image files
-        throw std::runtime_error("Invalid MNIST image file: incorrect magic number.");
+// Opens an IDX file for sequential streaming and reads its header into `header`
+int open_idx(const std::string& path, unsigned char* header, std::size_t header_size) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open file: " + path);
     }
+    try {
+        pread_fully(fd, header, header_size, 0, path);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return fd;
+}
 
-    file.read(reinterpret_cast<char*>(&num_images), sizeof(num_images));
-    num_images = reverse_int(num_images);
+} // namespace
 
-    file.read(reinterpret_cast<char*>(&num_rows), sizeof(num_rows));
-    num_rows = reverse_int(num_rows);
+MnistImageView::MnistImageView(const std::string& full_path)
+    : file_(full_path), pixels_(nullptr), count_(0), rows_(0), cols_(0) {
+    DNN_PROFILE_SCOPE(Profiler::Phase::Read);
+    if (file_.size() < kImageHeaderSize) {
+        throw std::runtime_error("Invalid MNIST image file: too small for header: " + full_path);
+    }
+    const unsigned char* base = file_.data();
 
-    file.read(reinterpret_cast<char*>(&num_cols), sizeof(num_cols));
-    num_cols = reverse_int(num_cols);
+    uint32_t magic_number = read_be_u32(base);
+    if (magic_number != 2051) { // Magic number for image files
+        throw std::runtime_error("Invalid MNIST image file: incorrect magic number.");
+    }
+    count_ = read_be_u32(base + 4);
+    rows_ = read_be_u32(base + 8);
+    cols_ = read_be_u32(base + 12);
 
-    std::vector<std::vector<unsigned char>> images(num_images);
-    uint32_t image_size = num_rows * num_cols;
+    std::size_t bytes;
+    if (!pixel_bytes(count_, rows_, cols_, bytes) || file_.size() - kImageHeaderSize != bytes) {
+        throw std::runtime_error("Invalid MNIST image file: size does not match header: " + full_path);
+    }
+    pixels_ = base + kImageHeaderSize;
+}
 
-    for (uint32_t i = 0; i < num_images; ++i) {
-        images[i].resize(image_size);
-        file.read(reinterpret_cast<char*>(images[i].data()), image_size);
-        if (!file) { // Check for read errors or EOF
-             throw std::runtime_error("Error reading image data from file or unexpected EOF.");
-        }
+MnistLabelView::MnistLabelView(const std::string& full_path)
+    : file_(full_path), labels_(nullptr), count_(0) {
+    DNN_PROFILE_SCOPE(Profiler::Phase::Read);
+    if (file_.size() < kLabelHeaderSize) {
+        throw std::runtime_error("Invalid MNIST label file: too small for header: " + full_path);
     }
+    const unsigned char* base = file_.data();
 
-    file.close();
-    return images;
+    uint32_t magic_number = read_be_u32(base);
+    if (magic_number != 2049) { // Magic number for label files
+        throw std::runtime_error("Invalid MNIST label file: incorrect magic number.");
+    }
+    count_ = read_be_u32(base + 4);
+
+    if (file_.size() - kLabelHeaderSize != count_) {
+        throw std::runtime_error("Invalid MNIST label file: size does not match header: " + full_path);
+    }
+    labels_ = base + kLabelHeaderSize;
 }
 
-std::vector<unsigned char> read_mnist_labels(const std::string& full_path) {
-    std::ifstream file(full_path, std::ios::binary);
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open file: " + full_path);
+MnistChunkStream::MnistChunkStream(const std::string& images_path, const std::string& labels_path,
+                                   std::size_t chunk_images)
+    : images_fd_(-1), labels_fd_(-1), images_path_(images_path), labels_path_(labels_path),
+      count_(0), rows_(0), cols_(0), chunk_images_(chunk_images), position_(0) {
+    if (chunk_images == 0) {
+        throw std::invalid_argument("MnistChunkStream: chunk_images must be non-zero.");
     }
+    unsigned char header[kImageHeaderSize];
+    images_fd_ = open_idx(images_path, header, kImageHeaderSize);
+    try {
+        if (read_be_u32(header) != 2051) {
+            throw std::runtime_error("Invalid MNIST image file: incorrect magic number.");
+        }
+        count_ = read_be_u32(header + 4);
+        rows_ = read_be_u32(header + 8);
+        cols_ = read_be_u32(header + 12);
+        std::size_t bytes;
+        if (!pixel_bytes(count_, rows_, cols_, bytes) || file_size(images_fd_, images_path) - kImageHeaderSize != bytes) {
+            throw std::runtime_error("Invalid MNIST image file: size does not match header: " + images_path);
+        }
 
-    uint32_t magic_number = 0;
-    uint32_t num_labels = 0;
+        labels_fd_ = open_idx(labels_path, header, kLabelHeaderSize);
+        if (read_be_u32(header) != 2049) {
+            throw std::runtime_error("Invalid MNIST label file: incorrect magic number.");
+        }
+        if (read_be_u32(header + 4) != count_) {
+            throw std::runtime_error("MNIST image and label files hold different sample counts.");
+        }
+        if (file_size(labels_fd_, labels_path) - kLabelHeaderSize != count_) {
+            throw std::runtime_error("Invalid MNIST label file: size does not match header: " + labels_path);
+        }
+    } catch (...) {
+        ::close(images_fd_);
+        if (labels_fd_ >= 0) {
+            ::close(labels_fd_);
+        }
+        throw;
+    }
 
-    file.read(reinterpret_cast<char*>(&magic_number), sizeof(magic_number));
-    magic_number = reverse_int(magic_number);
+    chunk_images_ = std::min(chunk_images_, std::max<std::size_t>(count_, 1));
+    pixels_.resize(chunk_images_ * image_size());
+    labels_.resize(chunk_images_);
+}
 
-    if (magic_number != 2049) { // Magic number for label files
-        throw std::runtime_error("Invalid MNIST label file: incorrect magic number.");
+MnistChunkStream::~MnistChunkStream() {
+    ::close(images_fd_);
+    ::close(labels_fd_);
+}
+
+bool MnistChunkStream::next(MnistChunk& chunk) {
+    if (position_ >= count_) {
+        return false;
     }
+    DNN_PROFILE_SCOPE(Profiler::Phase::Read);
+    const std::size_t width = image_size();
+    const std::size_t n = std::min(chunk_images_, count_ - position_);
+    const std::size_t pixel_offset = kImageHeaderSize + position_ * width;
+    const std::size_t label_offset = kLabelHeaderSize + position_;
+
+    // Start the kernel on the following chunk before blocking on this one
+    if (position_ + n < count_) {
+        const std::size_t ahead = std::min(chunk_images_, count_ - position_ - n);
+        ::posix_fadvise(images_fd_, static_cast<off_t>(pixel_offset + n * width),
+                        static_cast<off_t>(ahead * width), POSIX_FADV_WILLNEED);
+        ::posix_fadvise(labels_fd_, static_cast<off_t>(label_offset + n), static_cast<off_t>(ahead),
+                        POSIX_FADV_WILLNEED);
+    }
+    pread_fully(images_fd_, pixels_.data(), n * width, pixel_offset, images_path_);
+    pread_fully(labels_fd_, labels_.data(), n, label_offset, labels_path_);
+    // The data now lives in our buffers; keep the page cache from growing with the file
+    ::posix_fadvise(images_fd_, static_cast<off_t>(pixel_offset), static_cast<off_t>(n * width),
+                    POSIX_FADV_DONTNEED);
+
+    chunk.first = position_;
+    chunk.count = n;
+    chunk.pixels = Span<const unsigned char>(pixels_.data(), n * width);
+    chunk.labels = Span<const unsigned char>(labels_.data(), n);
+    position_ += n;
+    return true;
+}
+
+void MnistChunkStream::rewind() {
+    position_ = 0;
+}
 
-    file.read(reinterpret_cast<char*>(&num_labels), sizeof(num_labels));
-    num_labels = reverse_int(num_labels);
+std::vector<std::vector<unsigned char>> read_mnist_images(const std::string& full_path) {
+    MnistImageView view(full_path);
+    DNN_PROFILE_SCOPE(Profiler::Phase::Read); // The view times its own mapping
 
-    std::vector<unsigned char> labels(num_labels);
-    file.read(reinterpret_cast<char*>(labels.data()), num_labels);
-     if (!file) { // Check for read errors or EOF
-        throw std::runtime_error("Error reading label data from file or unexpected EOF.");
+    std::vector<std::vector<unsigned char>> images(view.count());
+    for (std::size_t i = 0; i < view.count(); ++i) {
+        Span<const unsigned char> image = view.image(i);
+        images[i].assign(image.begin(), image.end());
     }
+    return images;
+}
 
-    file.close();
-    return labels;
-}
\ No newline at end of file
+std::vector<unsigned char> read_mnist_labels(const std::string& full_path) {
+    MnistLabelView view(full_path);
+    DNN_PROFILE_SCOPE(Profiler::Phase::Read); // The view times its own mapping
+    Span<const unsigned char> labels = view.labels();
+    return std::vector<unsigned char>(labels.begin(), labels.end());
+}
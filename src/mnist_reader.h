@@ -1,9 +1,110 @@
 #ifndef MNIST_READER_H
 #define MNIST_READER_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "mapped_file.h"
+#include "span.h"
+
+// Zero-copy view of an IDX3 image file (magic 2051).
+// The file is memory-mapped; image(i) points straight into the mapping, so the
+// view must outlive any span it hands out. Pixels of all images are contiguous.
+class MnistImageView {
+public:
+    // Maps and validates the file. Throws std::runtime_error on a bad header or truncated file.
+    explicit MnistImageView(const std::string& full_path);
+
+    std::size_t count() const { return count_; }
+    std::size_t rows() const { return rows_; }
+    std::size_t cols() const { return cols_; }
+    std::size_t image_size() const { return rows_ * cols_; }
+
+    // Pixels of image i (row-major, rows() * cols() bytes)
+    Span<const unsigned char> image(std::size_t i) const {
+        return Span<const unsigned char>(pixels_ + i * image_size(), image_size());
+    }
+
+    // All pixels, count() * image_size() bytes
+    Span<const unsigned char> pixels() const {
+        return Span<const unsigned char>(pixels_, count_ * image_size());
+    }
+
+private:
+    MappedFile file_;
+    const unsigned char* pixels_;
+    std::size_t count_;
+    std::size_t rows_;
+    std::size_t cols_;
+};
+
+// Zero-copy view of an IDX1 label file (magic 2049).
+class MnistLabelView {
+public:
+    explicit MnistLabelView(const std::string& full_path);
+
+    std::size_t count() const { return count_; }
+    unsigned char label(std::size_t i) const { return labels_[i]; }
+    Span<const unsigned char> labels() const { return Span<const unsigned char>(labels_, count_); }
+
+private:
+    MappedFile file_;
+    const unsigned char* labels_;
+    std::size_t count_;
+};
+
+// One chunk of a MnistChunkStream: `count` consecutive images starting at sample `first`.
+// The spans point into the stream's buffers and stay valid until the next call to next().
+struct MnistChunk {
+    std::size_t first = 0;
+    std::size_t count = 0;
+    Span<const unsigned char> pixels; // count * image_size bytes
+    Span<const unsigned char> labels; // count bytes
+};
+
+// Sequential, bounded-memory reader over a matching IDX3 image / IDX1 label file pair.
+// Unlike the views it never maps the whole file: each next() fills fixed-size buffers with
+// large pread() calls, asks the kernel to read the following chunk ahead (posix_fadvise
+// WILLNEED) and drops the consumed range from the page cache, so files far larger than
+// RAM stream through at most chunk_images * (image_size + 1) bytes of buffers.
+class MnistChunkStream {
+public:
+    // Validates both headers and that each file size matches its header exactly.
+    // Throws std::runtime_error on a bad file and std::invalid_argument if chunk_images is 0.
+    MnistChunkStream(const std::string& images_path, const std::string& labels_path, std::size_t chunk_images);
+    ~MnistChunkStream();
+
+    MnistChunkStream(const MnistChunkStream&) = delete;
+    MnistChunkStream& operator=(const MnistChunkStream&) = delete;
+
+    std::size_t count() const { return count_; }
+    std::size_t rows() const { return rows_; }
+    std::size_t cols() const { return cols_; }
+    std::size_t image_size() const { return rows_ * cols_; }
+    std::size_t chunk_images() const { return chunk_images_; }
+
+    // Reads the next chunk (the last one may be short). Returns false at end of file.
+    bool next(MnistChunk& chunk);
+
+    // Starts over from the first sample
+    void rewind();
+
+private:
+    int images_fd_;
+    int labels_fd_;
+    std::string images_path_;
+    std::string labels_path_;
+    std::size_t count_;
+    std::size_t rows_;
+    std::size_t cols_;
+    std::size_t chunk_images_;
+    std::size_t position_; // First sample of the next chunk
+    std::vector<unsigned char> pixels_;
+    std::vector<unsigned char> labels_;
+};
+
 // Function to read MNIST images
 // Returns a vector of images, where each image is a vector of unsigned chars (pixel values)
 std::vector<std::vector<unsigned char>> read_mnist_images(const std::string& full_path);
@@ -12,4 +113,4 @@ std::vector<std::vector<unsigned char>> read_mnist_images(const std::string& ful
 // Returns a vector of unsigned chars (label values)
 std::vector<unsigned char> read_mnist_labels(const std::string& full_path);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,177 @@
+#include "neural_network.h"
+#include "loss_functions.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// The input layer needs no dL/dX, dense or sparse
+template <typename T>
+void backward_input_layer(const BasicDenseLayer<T>& layer, const Tensor2D<T>& input, const Tensor2D<T>& output,
+                          Tensor2D<T>& grad_output, BasicLayerGradients<T>& grads) {
+    layer.backward(input, output, grad_output, nullptr, grads);
+}
+
+template <typename T>
+void backward_input_layer(const BasicDenseLayer<T>& layer, const BasicSparseBatch<T>& input, const Tensor2D<T>& output,
+                          Tensor2D<T>& grad_output, BasicLayerGradients<T>& grads) {
+    layer.backward(input, output, grad_output, grads);
+}
+
+} // namespace
+
+template <typename T>
+BasicNeuralNetwork<T>::BasicNeuralNetwork() {
+}
+
+template <typename T>
+BasicNeuralNetwork<T>::BasicNeuralNetwork(const std::vector<std::size_t>& layer_sizes,
+                             Activations::Kind hidden_activation,
+                             uint32_t seed) {
+    if (layer_sizes.size() < 2) {
+        throw std::invalid_argument("NeuralNetwork: need at least an input and an output size.");
+    }
+    layers_.reserve(layer_sizes.size() - 1);
+    for (std::size_t i = 0; i + 1 < layer_sizes.size(); ++i) {
+        bool is_output = (i + 2 == layer_sizes.size());
+        Activations::Kind kind = is_output ? Activations::Kind::Identity : hidden_activation;
+        layers_.emplace_back(layer_sizes[i], layer_sizes[i + 1], kind, seed + static_cast<uint32_t>(i));
+    }
+}
+
+template <typename T>
+std::vector<BasicLayerGradients<T>> BasicNeuralNetwork<T>::make_gradients() const {
+    std::vector<BasicLayerGradients<T>> grads;
+    grads.reserve(layers_.size());
+    for (const BasicDenseLayer<T>& layer : layers_) {
+        grads.emplace_back(layer.inputs(), layer.outputs());
+    }
+    return grads;
+}
+
+template <typename T>
+std::size_t BasicNeuralNetwork<T>::workspace_bytes(std::size_t max_rows) const {
+    std::size_t bytes = Workspace::bytes_for<T>(max_rows * input_size()); // dense_input
+    for (const BasicDenseLayer<T>& layer : layers_) {
+        bytes += 2 * Workspace::bytes_for<T>(max_rows * layer.outputs()); // Output and its gradient
+    }
+    return bytes;
+}
+
+template <typename T>
+void BasicNeuralNetwork<T>::bind_buffers(BasicPassBuffers<T>& buffers, Workspace& workspace, std::size_t max_rows) const {
+    buffers.outputs.resize(layers_.size());
+    buffers.grads.resize(layers_.size());
+    for (std::size_t i = 0; i < layers_.size(); ++i) {
+        std::size_t elements = max_rows * layers_[i].outputs();
+        buffers.outputs[i].attach(workspace.allocate<T>(elements), elements);
+        buffers.grads[i].attach(workspace.allocate<T>(elements), elements);
+    }
+    buffers.dense_input.attach(workspace.allocate<T>(max_rows * input_size()), max_rows * input_size());
+}
+
+template <typename T>
+template <typename Input>
+const Tensor2D<T>& BasicNeuralNetwork<T>::forward_impl(const Input& input, BasicPassBuffers<T>& buffers) const {
+    DNN_PROFILE_SCOPE(Profiler::Phase::Forward);
+    buffers.outputs.resize(layers_.size());
+    layers_[0].forward(input, buffers.outputs[0]);
+    for (std::size_t i = 1; i < layers_.size(); ++i) {
+        layers_[i].forward(buffers.outputs[i - 1], buffers.outputs[i]);
+    }
+    return buffers.outputs.back();
+}
+
+template <typename T>
+const Tensor2D<T>& BasicNeuralNetwork<T>::forward(const Tensor2D<T>& input, BasicPassBuffers<T>& buffers) const {
+    return forward_impl(input, buffers);
+}
+
+template <typename T>
+const Tensor2D<T>& BasicNeuralNetwork<T>::forward(const BasicSparseBatch<T>& input, BasicPassBuffers<T>& buffers) const {
+    if (input.density() > Sparse::kMaxDensity) {
+        input.to_dense(buffers.dense_input);
+        return forward_impl(buffers.dense_input, buffers);
+    }
+    return forward_impl(input, buffers);
+}
+
+template <typename T>
+template <typename Input>
+double BasicNeuralNetwork<T>::compute_gradients_impl(const Input& input,
+                                                     Span<const unsigned char> labels,
+                                                     T grad_scale,
+                                                     BasicPassBuffers<T>& buffers,
+                                                     std::vector<BasicLayerGradients<T>>& grads,
+                                                     std::size_t* correct) const {
+    if (labels.size() != input.rows()) {
+        throw std::invalid_argument("NeuralNetwork::compute_gradients: one label per input row is required.");
+    }
+    const Tensor2D<T>& logits = forward_impl(input, buffers);
+    std::size_t batch = input.rows();
+    std::size_t classes = output_size();
+
+    if (correct != nullptr) {
+        for (std::size_t r = 0; r < batch; ++r) {
+            const T* row = logits.data() + r * classes;
+            std::size_t predicted = std::max_element(row, row + classes) - row;
+            *correct += (predicted == labels[r]) ? 1 : 0;
+        }
+    }
+
+    DNN_PROFILE_SCOPE(Profiler::Phase::Backward);
+    buffers.grads.resize(layers_.size());
+    Tensor2D<T>& top_grad = buffers.grads.back();
+    top_grad.resize(batch, classes);
+    double loss = LossFunctions::softmax_cross_entropy<T>(logits.flat(), labels, top_grad.flat(), classes);
+    if (grad_scale != T(1)) {
+        for (std::size_t i = 0; i < top_grad.size(); ++i) {
+            top_grad.data()[i] *= grad_scale;
+        }
+    }
+
+    for (std::size_t i = layers_.size() - 1; i > 0; --i) {
+        layers_[i].backward(buffers.outputs[i - 1], buffers.outputs[i], buffers.grads[i], &buffers.grads[i - 1], grads[i]);
+    }
+    backward_input_layer(layers_[0], input, buffers.outputs[0], buffers.grads[0], grads[0]);
+    return loss;
+}
+
+template <typename T>
+double BasicNeuralNetwork<T>::compute_gradients(const Tensor2D<T>& input,
+                                                Span<const unsigned char> labels,
+                                                T grad_scale,
+                                                BasicPassBuffers<T>& buffers,
+                                                std::vector<BasicLayerGradients<T>>& grads,
+                                                std::size_t* correct) const {
+    return compute_gradients_impl(input, labels, grad_scale, buffers, grads, correct);
+}
+
+template <typename T>
+double BasicNeuralNetwork<T>::compute_gradients(const BasicSparseBatch<T>& input,
+                                                Span<const unsigned char> labels,
+                                                T grad_scale,
+                                                BasicPassBuffers<T>& buffers,
+                                                std::vector<BasicLayerGradients<T>>& grads,
+                                                std::size_t* correct) const {
+    if (input.density() > Sparse::kMaxDensity) {
+        input.to_dense(buffers.dense_input);
+        return compute_gradients_impl(buffers.dense_input, labels, grad_scale, buffers, grads, correct);
+    }
+    return compute_gradients_impl(input, labels, grad_scale, buffers, grads, correct);
+}
+
+template <typename T>
+void argmax_rows(const Tensor2D<T>& logits, Span<unsigned char> out) {
+    for (std::size_t r = 0; r < logits.rows(); ++r) {
+        const T* row = logits.data() + r * logits.cols();
+        out[r] = static_cast<unsigned char>(std::max_element(row, row + logits.cols()) - row);
+    }
+}
+
+template class BasicNeuralNetwork<float>;
+template class BasicNeuralNetwork<double>;
+template void argmax_rows<float>(const Tensor2D<float>&, Span<unsigned char>);
+template void argmax_rows<double>(const Tensor2D<double>&, Span<unsigned char>);
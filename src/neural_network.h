@@ -0,0 +1,124 @@
+#ifndef NEURAL_NETWORK_H
+#define NEURAL_NETWORK_H
+
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "activation_functions.h"
+#include "layer.h"
+#include "sparse_batch.h"
+#include "span.h"
+#include "tensor.h"
+#include "workspace.h"
+
+// Per-pass scratch: the output and gradient of every layer for one batch.
+// Each thread that runs passes owns one, so the network itself stays read-only.
+// The tensors grow on demand, or can be bound once to a Workspace with
+// BasicNeuralNetwork::bind_buffers so that no pass ever allocates.
+template <typename T>
+struct BasicPassBuffers {
+    std::vector<Tensor2D<T>> outputs; // outputs[i] = activated output of layer i
+    std::vector<Tensor2D<T>> grads;   // grads[i] = dL/d(outputs[i]), reused as dZ in place
+    Tensor2D<T> dense_input;          // A sparse input expanded for the dense path
+};
+
+// A stack of DenseLayers ending in raw logits; softmax is applied by the loss.
+// Instantiated for float (the NeuralNetwork alias used everywhere) and double.
+template <typename T>
+class BasicNeuralNetwork {
+public:
+    BasicNeuralNetwork();
+
+    /**
+     * @param layer_sizes Widths including input and output, e.g. {784, 128, 10}.
+     * @param hidden_activation Activation of every layer except the last (which is Identity).
+     * @param seed Seeds the weight initialization of every layer.
+     */
+    BasicNeuralNetwork(const std::vector<std::size_t>& layer_sizes, Activations::Kind hidden_activation, uint32_t seed);
+
+    // Same topology and parameters converted to another scalar type
+    template <typename U>
+    explicit BasicNeuralNetwork(const BasicNeuralNetwork<U>& other);
+
+    std::size_t num_layers() const { return layers_.size(); }
+    std::size_t input_size() const { return layers_.front().inputs(); }
+    std::size_t output_size() const { return layers_.back().outputs(); }
+
+    std::vector<BasicDenseLayer<T>>& layers() { return layers_; }
+    const std::vector<BasicDenseLayer<T>>& layers() const { return layers_; }
+
+    // Gradient buffers shaped like this network, zero-initialized
+    std::vector<BasicLayerGradients<T>> make_gradients() const;
+
+    // Workspace bytes bind_buffers() needs for batches of up to max_rows rows (dense or sparse)
+    std::size_t workspace_bytes(std::size_t max_rows) const;
+
+    // Carves every layer output and gradient tensor of buffers out of workspace, sized for
+    // up to max_rows rows. Passes over at most max_rows rows then run without touching the
+    // heap; the slices stay bound until the workspace is reset or reallocated.
+    void bind_buffers(BasicPassBuffers<T>& buffers, Workspace& workspace, std::size_t max_rows) const;
+
+    // Runs the batch through every layer; returns the logits (B x output_size()), stored in buffers.
+    const Tensor2D<T>& forward(const Tensor2D<T>& input, BasicPassBuffers<T>& buffers) const;
+
+    // Same for a sparse batch. The input layer runs the sparse kernel while
+    // input.density() <= Sparse::kMaxDensity; denser batches are expanded into
+    // buffers.dense_input and take the GEMM path.
+    const Tensor2D<T>& forward(const BasicSparseBatch<T>& input, BasicPassBuffers<T>& buffers) const;
+
+    /**
+     * @brief Forward pass, softmax cross-entropy, and backward pass for one batch (or shard).
+     * Parameter gradients are *added* to grads, scaled by grad_scale. Pass
+     * shard_size / batch_size so that summing the shards of a batch gives the batch-mean gradient.
+     * @param correct If non-null, incremented by the number of rows whose argmax matches the label.
+     * @return Mean loss over the rows of input.
+     */
+    double compute_gradients(const Tensor2D<T>& input,
+                             Span<const unsigned char> labels,
+                             T grad_scale,
+                             BasicPassBuffers<T>& buffers,
+                             std::vector<BasicLayerGradients<T>>& grads,
+                             std::size_t* correct) const;
+
+    // compute_gradients() for a sparse batch, with the same density switch as forward()
+    double compute_gradients(const BasicSparseBatch<T>& input,
+                             Span<const unsigned char> labels,
+                             T grad_scale,
+                             BasicPassBuffers<T>& buffers,
+                             std::vector<BasicLayerGradients<T>>& grads,
+                             std::size_t* correct) const;
+
+private:
+    // Shared by the dense and sparse entry points; Input is Tensor2D<T> or BasicSparseBatch<T>
+    template <typename Input>
+    const Tensor2D<T>& forward_impl(const Input& input, BasicPassBuffers<T>& buffers) const;
+    template <typename Input>
+    double compute_gradients_impl(const Input& input, Span<const unsigned char> labels, T grad_scale,
+                                  BasicPassBuffers<T>& buffers, std::vector<BasicLayerGradients<T>>& grads,
+                                  std::size_t* correct) const;
+
+    std::vector<BasicDenseLayer<T>> layers_;
+};
+
+template <typename T>
+template <typename U>
+BasicNeuralNetwork<T>::BasicNeuralNetwork(const BasicNeuralNetwork<U>& other) {
+    layers_.reserve(other.num_layers());
+    for (const BasicDenseLayer<U>& src : other.layers()) {
+        layers_.emplace_back(src.inputs(), src.outputs(), src.activation(), 0);
+        BasicDenseLayer<T>& dst = layers_.back();
+        std::copy(src.weights().data(), src.weights().data() + src.weights().size(), dst.weights().data());
+        std::copy(src.biases().data(), src.biases().data() + src.biases().size(), dst.biases().data());
+    }
+}
+
+typedef BasicPassBuffers<float> PassBuffers;
+typedef BasicNeuralNetwork<float> NeuralNetwork;
+
+// Index of the largest value in each row of logits, written to out (size = rows)
+template <typename T>
+void argmax_rows(const Tensor2D<T>& logits, Span<unsigned char> out);
+
+#endif // NEURAL_NETWORK_H
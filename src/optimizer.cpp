@@ -0,0 +1,54 @@
+#include "optimizer.h"
+#include "profiler.h"
+
+#include <stdexcept>
+
+namespace {
+
+template <typename T>
+void update(Tensor2D<T>& param, const Tensor2D<T>& grad, Tensor2D<T>* velocity,
+            T learning_rate, T momentum) {
+    T* w = param.data();
+    const T* g = grad.data();
+    std::size_t n = param.size();
+    if (velocity == nullptr) {
+        for (std::size_t i = 0; i < n; ++i) {
+            w[i] -= learning_rate * g[i];
+        }
+        return;
+    }
+    T* v = velocity->data();
+    for (std::size_t i = 0; i < n; ++i) {
+        v[i] = momentum * v[i] - learning_rate * g[i];
+        w[i] += v[i];
+    }
+}
+
+} // namespace
+
+template <typename T>
+BasicSgdOptimizer<T>::BasicSgdOptimizer(float learning_rate, float momentum)
+    : learning_rate_(learning_rate), momentum_(momentum) {
+}
+
+template <typename T>
+void BasicSgdOptimizer<T>::step(BasicNeuralNetwork<T>& network, const std::vector<BasicLayerGradients<T>>& grads) {
+    DNN_PROFILE_SCOPE(Profiler::Phase::OptimizerStep);
+    std::vector<BasicDenseLayer<T>>& layers = network.layers();
+    if (grads.size() != layers.size()) {
+        throw std::invalid_argument("SgdOptimizer::step: one gradient set per layer is required.");
+    }
+    if (momentum_ != 0.0f && velocity_.empty()) {
+        velocity_ = network.make_gradients();
+    }
+    for (std::size_t i = 0; i < layers.size(); ++i) {
+        BasicLayerGradients<T>* v = velocity_.empty() ? nullptr : &velocity_[i];
+        const T lr = static_cast<T>(learning_rate_);
+        const T momentum = static_cast<T>(momentum_);
+        update(layers[i].weights(), grads[i].weights, v ? &v->weights : nullptr, lr, momentum);
+        update(layers[i].biases(), grads[i].biases, v ? &v->biases : nullptr, lr, momentum);
+    }
+}
+
+template class BasicSgdOptimizer<float>;
+template class BasicSgdOptimizer<double>;
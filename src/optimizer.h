@@ -0,0 +1,31 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <vector>
+
+#include "layer.h"
+#include "neural_network.h"
+
+// Stochastic Gradient Descent with optional classical momentum:
+// v = momentum * v - learning_rate * g;  w += v
+// Templated on the network's scalar type; SgdOptimizer is the float instantiation.
+template <typename T>
+class BasicSgdOptimizer {
+public:
+    explicit BasicSgdOptimizer(float learning_rate, float momentum = 0.0f);
+
+    float learning_rate() const { return learning_rate_; }
+    void set_learning_rate(float learning_rate) { learning_rate_ = learning_rate; }
+
+    // Applies one update to every layer. grads must be shaped like network.make_gradients().
+    void step(BasicNeuralNetwork<T>& network, const std::vector<BasicLayerGradients<T>>& grads);
+
+private:
+    float learning_rate_;
+    float momentum_;
+    std::vector<BasicLayerGradients<T>> velocity_; // Created on the first step when momentum is used
+};
+
+typedef BasicSgdOptimizer<float> SgdOptimizer;
+
+#endif // OPTIMIZER_H
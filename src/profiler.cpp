@@ -0,0 +1,269 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+#ifndef DNN_DISABLE_STATS
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <vector>
+#endif
+
+namespace Profiler {
+
+    const char* phase_name(Phase phase) {
+        switch (phase) {
+            case Phase::Read: return "read";
+            case Phase::Process: return "process";
+            case Phase::Forward: return "forward";
+            case Phase::Backward: return "backward";
+            case Phase::OptimizerStep: return "optimizer_step";
+            case Phase::LoaderWait: return "loader_wait";
+            case Phase::Count: break;
+        }
+        return "unknown";
+    }
+
+    void print_summary(std::ostream& out, const Snapshot& begin, const Snapshot& end, std::size_t samples) {
+#ifdef DNN_DISABLE_STATS
+        (void)out;
+        (void)begin;
+        (void)end;
+        (void)samples;
+#else
+        double wall = end.wall_seconds - begin.wall_seconds;
+        std::ios::fmtflags flags = out.flags();
+        out << std::fixed << std::setprecision(1)
+            << "  " << samples << " samples in " << wall * 1e3 << " ms ("
+            << std::setprecision(0) << (wall > 0.0 ? samples / wall : 0.0) << " samples/s)\n";
+        for (std::size_t p = 0; p < kNumPhases; ++p) {
+            uint64_t calls = end.phase_calls[p] - begin.phase_calls[p];
+            if (calls == 0) {
+                continue;
+            }
+            double ms = (end.phase_ns[p] - begin.phase_ns[p]) * 1e-6;
+            out << "  " << std::left << std::setw(16) << phase_name(static_cast<Phase>(p)) << std::right
+                << std::setprecision(1) << std::setw(10) << ms << " ms"
+                << std::setw(10) << calls << " calls"
+                << std::setw(8) << (wall > 0.0 ? 100.0 * ms * 1e-3 / wall : 0.0) << "% of wall\n";
+        }
+        out << "  allocations     " << (end.allocations - begin.allocations) << " ("
+            << (end.allocated_bytes - begin.allocated_bytes) << " bytes)\n";
+        out.flags(flags);
+#endif
+    }
+
+#ifndef DNN_DISABLE_STATS
+
+    namespace {
+
+        struct TraceEvent {
+            Phase phase;
+            uint64_t start_ns;
+            uint64_t end_ns;
+        };
+
+        // One per thread, written only by its owner. Never freed, so totals from
+        // finished threads are kept and snapshot() never races with a teardown.
+        struct ThreadBlock {
+            std::atomic<uint64_t> phase_ns[kNumPhases];
+            std::atomic<uint64_t> phase_calls[kNumPhases];
+            std::atomic<uint64_t> allocations;
+            std::atomic<uint64_t> allocated_bytes;
+            std::vector<TraceEvent>* events;
+            std::size_t thread_index;
+        };
+
+        const std::size_t kMaxThreads = 256;
+        std::atomic<ThreadBlock*> g_blocks[kMaxThreads];
+        std::atomic<std::size_t> g_num_blocks(0);
+        std::atomic<bool> g_tracing(false);
+        const std::chrono::steady_clock::time_point g_origin = std::chrono::steady_clock::now();
+
+        // Blocks are created with malloc + placement new: this runs inside operator new,
+        // so it must not allocate through operator new itself.
+        ThreadBlock* new_block(std::size_t index) {
+            void* memory = std::malloc(sizeof(ThreadBlock));
+            if (memory == nullptr) {
+                std::abort();
+            }
+            ThreadBlock* block = new (memory) ThreadBlock;
+            for (std::size_t p = 0; p < kNumPhases; ++p) {
+                block->phase_ns[p].store(0, std::memory_order_relaxed);
+                block->phase_calls[p].store(0, std::memory_order_relaxed);
+            }
+            block->allocations.store(0, std::memory_order_relaxed);
+            block->allocated_bytes.store(0, std::memory_order_relaxed);
+            block->events = nullptr;
+            block->thread_index = index;
+            return block;
+        }
+
+        // Threads beyond kMaxThreads share this block through atomic adds
+        ThreadBlock* overflow_block() {
+            static ThreadBlock* block = new_block(kMaxThreads);
+            return block;
+        }
+
+        thread_local ThreadBlock* t_block = nullptr;
+
+        ThreadBlock* this_thread_block() {
+            if (t_block == nullptr) {
+                std::size_t index = g_num_blocks.fetch_add(1, std::memory_order_relaxed);
+                if (index < kMaxThreads) {
+                    t_block = new_block(index);
+                    g_blocks[index].store(t_block, std::memory_order_release);
+                } else {
+                    t_block = overflow_block();
+                }
+            }
+            return t_block;
+        }
+
+        // Single-writer increment; falls back to an atomic add on the shared overflow block
+        void bump(ThreadBlock* block, std::atomic<uint64_t>& counter, uint64_t amount) {
+            if (block->thread_index < kMaxThreads) {
+                counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+            } else {
+                counter.fetch_add(amount, std::memory_order_relaxed);
+            }
+        }
+
+        void count_allocation(std::size_t size) {
+            ThreadBlock* block = this_thread_block();
+            bump(block, block->allocations, 1);
+            bump(block, block->allocated_bytes, size);
+        }
+
+    } // namespace
+
+    uint64_t now_ns() {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_origin).count());
+    }
+
+    void record(Phase phase, uint64_t start_ns, uint64_t end_ns) {
+        ThreadBlock* block = this_thread_block();
+        std::size_t p = static_cast<std::size_t>(phase);
+        bump(block, block->phase_ns[p], end_ns - start_ns);
+        bump(block, block->phase_calls[p], 1);
+        if (g_tracing.load(std::memory_order_relaxed) && block->thread_index < kMaxThreads) {
+            if (block->events == nullptr) {
+                block->events = new std::vector<TraceEvent>();
+                block->events->reserve(4096);
+            }
+            block->events->push_back(TraceEvent{phase, start_ns, end_ns});
+        }
+    }
+
+    Snapshot snapshot() {
+        Snapshot snap;
+        auto add = [&snap](const ThreadBlock* block) {
+            for (std::size_t p = 0; p < kNumPhases; ++p) {
+                snap.phase_ns[p] += block->phase_ns[p].load(std::memory_order_relaxed);
+                snap.phase_calls[p] += block->phase_calls[p].load(std::memory_order_relaxed);
+            }
+            snap.allocations += block->allocations.load(std::memory_order_relaxed);
+            snap.allocated_bytes += block->allocated_bytes.load(std::memory_order_relaxed);
+        };
+
+        std::size_t claimed = g_num_blocks.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < std::min(claimed, kMaxThreads); ++i) {
+            ThreadBlock* block = g_blocks[i].load(std::memory_order_acquire);
+            if (block != nullptr) { // Null while a new thread is still publishing its block
+                add(block);
+            }
+        }
+        if (claimed > kMaxThreads) {
+            add(overflow_block());
+        }
+        snap.wall_seconds = now_ns() * 1e-9;
+        return snap;
+    }
+
+    void start_trace() {
+        g_tracing.store(true, std::memory_order_relaxed);
+    }
+
+    void write_trace(const std::string& path) {
+        std::ofstream out(path);
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot open file: " + path);
+        }
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+        char line[160];
+        std::size_t count = std::min(g_num_blocks.load(std::memory_order_acquire), kMaxThreads);
+        for (std::size_t i = 0; i < count; ++i) {
+            ThreadBlock* block = g_blocks[i].load(std::memory_order_acquire);
+            if (block == nullptr || block->events == nullptr) {
+                continue;
+            }
+            for (const TraceEvent& e : *block->events) {
+                // Trace timestamps are microseconds
+                std::snprintf(line, sizeof(line),
+                              "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+                              first ? "" : ",\n", phase_name(e.phase), i, e.start_ns * 1e-3,
+                              (e.end_ns - e.start_ns) * 1e-3);
+                out << line;
+                first = false;
+            }
+        }
+        out << "\n]}\n";
+        if (!out) {
+            throw std::runtime_error("Error writing trace file: " + path);
+        }
+    }
+
+#endif // DNN_DISABLE_STATS
+
+} // namespace Profiler
+
+#ifndef DNN_DISABLE_STATS
+
+// Counting replacements for the global allocation functions. The remaining forms
+// (array, nothrow) are defined by the standard library in terms of these.
+
+void* operator new(std::size_t size) {
+    Profiler::count_allocation(size);
+    void* p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    Profiler::count_allocation(size);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a size that is a multiple of the alignment
+    std::size_t rounded = (size + align - 1) / align * align;
+    void* p = std::aligned_alloc(align, rounded == 0 ? align : rounded);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+#endif // DNN_DISABLE_STATS
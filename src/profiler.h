@@ -0,0 +1,97 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Low-overhead hot-path instrumentation.
+//
+// DNN_PROFILE_SCOPE(phase) times the enclosing scope into per-thread counters. Each
+// thread owns its counter block (single writer, relaxed atomics), and snapshot() sums
+// the blocks, so recording never takes a lock. While tracing is on, each scope is also
+// logged as a Chrome trace event ("X" phase) that write_trace() dumps as JSON for
+// chrome://tracing or Perfetto. Heap allocations (operator new) are counted per thread too.
+//
+// Build with -DDNN_DISABLE_STATS to compile all of it out: the macro expands to nothing,
+// the functions become empty inlines, and operator new is not replaced.
+namespace Profiler {
+
+    enum class Phase {
+        Read,
+        Process,
+        Forward,
+        Backward,
+        OptimizerStep,
+        LoaderWait,
+        Count
+    };
+
+    const std::size_t kNumPhases = static_cast<std::size_t>(Phase::Count);
+
+    const char* phase_name(Phase phase);
+
+    // Totals summed over every thread since program start
+    struct Snapshot {
+        uint64_t phase_ns[kNumPhases] = {};
+        uint64_t phase_calls[kNumPhases] = {};
+        uint64_t allocations = 0;
+        uint64_t allocated_bytes = 0;
+        double wall_seconds = 0.0; // steady_clock time when the snapshot was taken
+    };
+
+    /**
+     * @brief Prints what happened between two snapshots, e.g. one epoch:
+     * samples/sec, thread-time and call count per phase, and heap allocations.
+     * Phase times are summed across threads, so parallel phases can exceed wall time.
+     */
+    void print_summary(std::ostream& out, const Snapshot& begin, const Snapshot& end, std::size_t samples);
+
+#ifndef DNN_DISABLE_STATS
+
+    // Monotonic nanoseconds (steady_clock; a vDSO call, ~20 ns)
+    uint64_t now_ns();
+
+    void record(Phase phase, uint64_t start_ns, uint64_t end_ns);
+
+    Snapshot snapshot();
+
+    // Starts collecting trace events on every thread
+    void start_trace();
+
+    // Writes all collected events as Chrome trace JSON. Call once instrumented threads are idle.
+    void write_trace(const std::string& path);
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Phase phase) : phase_(phase), start_(now_ns()) {}
+        ~ScopedTimer() { record(phase_, start_, now_ns()); }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Phase phase_;
+        uint64_t start_;
+    };
+
+#define DNN_PROFILE_CONCAT_INNER(a, b) a##b
+#define DNN_PROFILE_CONCAT(a, b) DNN_PROFILE_CONCAT_INNER(a, b)
+#define DNN_PROFILE_SCOPE(phase) ::Profiler::ScopedTimer DNN_PROFILE_CONCAT(dnn_profile_scope_, __LINE__)(phase)
+
+#else
+
+    inline uint64_t now_ns() { return 0; }
+    inline void record(Phase, uint64_t, uint64_t) {}
+    inline Snapshot snapshot() { return Snapshot(); }
+    inline void start_trace() {}
+    inline void write_trace(const std::string&) {}
+
+#define DNN_PROFILE_SCOPE(phase) ((void)0)
+
+#endif // DNN_DISABLE_STATS
+
+} // namespace Profiler
+
+#endif // PROFILER_H
@@ -0,0 +1,251 @@
+#include "quantized_network.h"
+#include "cpu_features.h"
+#include "data_processor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if DNN_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const std::size_t kCalibrationBatch = 256;
+
+int32_t dot_u8s8_scalar(const unsigned char* x, const int8_t* w, std::size_t n) {
+    int32_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        sum += static_cast<int32_t>(x[i]) * static_cast<int32_t>(w[i]);
+    }
+    return sum;
+}
+
+// acc[j] = x . w[j] for every output j of one sample (w is outputs x inputs)
+void layer_row_scalar(const unsigned char* x, const int8_t* w, std::size_t inputs, std::size_t outputs,
+                      int32_t* acc) {
+    for (std::size_t j = 0; j < outputs; ++j) {
+        acc[j] = dot_u8s8_scalar(x, w + j * inputs, inputs);
+    }
+}
+
+#if DNN_X86
+// Widens both operands to int16 before _mm256_madd_epi16, so unlike _mm256_maddubs_epi16
+// the pairwise sums cannot saturate (255 * 127 * 2 > INT16_MAX).
+// Four outputs are computed together so each widened input vector is reused four times
+// and the four horizontal sums collapse into one hadd tree.
+DNN_TARGET("avx2")
+void layer_row_avx2(const unsigned char* x, const int8_t* w, std::size_t inputs, std::size_t outputs,
+                    int32_t* acc) {
+    const std::size_t vec_end = inputs / 16 * 16;
+    std::size_t j = 0;
+    for (; j + 4 <= outputs; j += 4) {
+        const int8_t* w0 = w + (j + 0) * inputs;
+        const int8_t* w1 = w + (j + 1) * inputs;
+        const int8_t* w2 = w + (j + 2) * inputs;
+        const int8_t* w3 = w + (j + 3) * inputs;
+        __m256i a0 = _mm256_setzero_si256(), a1 = _mm256_setzero_si256();
+        __m256i a2 = _mm256_setzero_si256(), a3 = _mm256_setzero_si256();
+        for (std::size_t i = 0; i < vec_end; i += 16) {
+            __m256i xv = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i)));
+            a0 = _mm256_add_epi32(a0, _mm256_madd_epi16(xv, _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w0 + i)))));
+            a1 = _mm256_add_epi32(a1, _mm256_madd_epi16(xv, _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w1 + i)))));
+            a2 = _mm256_add_epi32(a2, _mm256_madd_epi16(xv, _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w2 + i)))));
+            a3 = _mm256_add_epi32(a3, _mm256_madd_epi16(xv, _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w3 + i)))));
+        }
+        __m256i sums = _mm256_hadd_epi32(_mm256_hadd_epi32(a0, a1), _mm256_hadd_epi32(a2, a3));
+        __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + j), total);
+
+        const std::size_t tail = inputs - vec_end;
+        acc[j + 0] += dot_u8s8_scalar(x + vec_end, w0 + vec_end, tail);
+        acc[j + 1] += dot_u8s8_scalar(x + vec_end, w1 + vec_end, tail);
+        acc[j + 2] += dot_u8s8_scalar(x + vec_end, w2 + vec_end, tail);
+        acc[j + 3] += dot_u8s8_scalar(x + vec_end, w3 + vec_end, tail);
+    }
+    for (; j < outputs; ++j) {
+        acc[j] = dot_u8s8_scalar(x, w + j * inputs, inputs);
+    }
+}
+
+// VPDPBUSD multiplies 64 u8 x s8 pairs and adds each group of four straight into an
+// int32 lane, with no int16 intermediate to saturate. The input tail uses a masked load.
+DNN_TARGET("avx2,avx512f,avx512bw,avx512vnni")
+void layer_row_avx512vnni(const unsigned char* x, const int8_t* w, std::size_t inputs, std::size_t outputs,
+                          int32_t* acc) {
+    const std::size_t vec_end = inputs / 64 * 64;
+    const __mmask64 tail_mask = (inputs == vec_end) ? 0 : (~0ULL >> (64 - (inputs - vec_end)));
+    std::size_t j = 0;
+    for (; j + 4 <= outputs; j += 4) {
+        const int8_t* w0 = w + (j + 0) * inputs;
+        const int8_t* w1 = w + (j + 1) * inputs;
+        const int8_t* w2 = w + (j + 2) * inputs;
+        const int8_t* w3 = w + (j + 3) * inputs;
+        __m512i a0 = _mm512_setzero_si512(), a1 = _mm512_setzero_si512();
+        __m512i a2 = _mm512_setzero_si512(), a3 = _mm512_setzero_si512();
+        for (std::size_t i = 0; i < vec_end; i += 64) {
+            __m512i xv = _mm512_loadu_si512(x + i);
+            a0 = _mm512_dpbusd_epi32(a0, xv, _mm512_loadu_si512(w0 + i));
+            a1 = _mm512_dpbusd_epi32(a1, xv, _mm512_loadu_si512(w1 + i));
+            a2 = _mm512_dpbusd_epi32(a2, xv, _mm512_loadu_si512(w2 + i));
+            a3 = _mm512_dpbusd_epi32(a3, xv, _mm512_loadu_si512(w3 + i));
+        }
+        if (tail_mask != 0) {
+            __m512i xv = _mm512_maskz_loadu_epi8(tail_mask, x + vec_end);
+            a0 = _mm512_dpbusd_epi32(a0, xv, _mm512_maskz_loadu_epi8(tail_mask, w0 + vec_end));
+            a1 = _mm512_dpbusd_epi32(a1, xv, _mm512_maskz_loadu_epi8(tail_mask, w1 + vec_end));
+            a2 = _mm512_dpbusd_epi32(a2, xv, _mm512_maskz_loadu_epi8(tail_mask, w2 + vec_end));
+            a3 = _mm512_dpbusd_epi32(a3, xv, _mm512_maskz_loadu_epi8(tail_mask, w3 + vec_end));
+        }
+        // Fold each accumulator to 256 bits, then one hadd tree for all four
+        // (zero-masked extracts: the unmasked forms trip a GCC 12 -Wmaybe-uninitialized false positive)
+        __m256i h0 = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(0xFF, a0, 0), _mm512_maskz_extracti64x4_epi64(0xFF, a0, 1));
+        __m256i h1 = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(0xFF, a1, 0), _mm512_maskz_extracti64x4_epi64(0xFF, a1, 1));
+        __m256i h2 = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(0xFF, a2, 0), _mm512_maskz_extracti64x4_epi64(0xFF, a2, 1));
+        __m256i h3 = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(0xFF, a3, 0), _mm512_maskz_extracti64x4_epi64(0xFF, a3, 1));
+        __m256i sums = _mm256_hadd_epi32(_mm256_hadd_epi32(h0, h1), _mm256_hadd_epi32(h2, h3));
+        __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + j), total);
+    }
+    for (; j < outputs; ++j) {
+        acc[j] = dot_u8s8_scalar(x, w + j * inputs, inputs);
+    }
+}
+#endif
+
+typedef void (*RowKernel)(const unsigned char*, const int8_t*, std::size_t, std::size_t, int32_t*);
+
+RowKernel select_row_kernel() {
+#if DNN_X86
+    if (CpuFeatures::has_avx512bw() && CpuFeatures::has_avx512vnni()) {
+        return layer_row_avx512vnni;
+    }
+    if (CpuFeatures::has_avx2()) {
+        return layer_row_avx2;
+    }
+#endif
+    return layer_row_scalar;
+}
+
+} // namespace
+
+QuantizedNetwork::QuantizedNetwork(const NeuralNetwork& network, Span<const unsigned char> calibration_pixels) {
+    const std::vector<DenseLayer>& src = network.layers();
+    if (src.empty()) {
+        throw std::invalid_argument("QuantizedNetwork: network has no layers.");
+    }
+    for (std::size_t l = 0; l + 1 < src.size(); ++l) {
+        if (src[l].activation() != Activations::Kind::ReLU) {
+            throw std::invalid_argument("QuantizedNetwork: hidden layers must use ReLU.");
+        }
+    }
+    std::size_t width = network.input_size();
+    if (calibration_pixels.empty() || calibration_pixels.size() % width != 0) {
+        throw std::invalid_argument("QuantizedNetwork: calibration pixels must be a non-empty whole number of images.");
+    }
+
+    // Largest output of every hidden layer over the calibration set
+    std::vector<float> max_output(src.size(), 0.0f);
+    DataProcessor processor;
+    Batch batch;
+    PassBuffers buffers;
+    std::size_t num_images = calibration_pixels.size() / width;
+    for (std::size_t offset = 0; offset < num_images; offset += kCalibrationBatch) {
+        std::size_t rows = std::min(kCalibrationBatch, num_images - offset);
+        processor.process_images_into(calibration_pixels.subspan(offset * width, rows * width), width, batch);
+        network.forward(batch, buffers);
+        for (std::size_t l = 0; l + 1 < src.size(); ++l) {
+            const Tensor2D<float>& out = buffers.outputs[l];
+            max_output[l] = std::max(max_output[l], *std::max_element(out.data(), out.data() + out.size()));
+        }
+    }
+
+    float input_scale = 1.0f / 255.0f;
+    layers_.resize(src.size());
+    for (std::size_t l = 0; l < src.size(); ++l) {
+        const DenseLayer& dense = src[l];
+        Layer& q = layers_[l];
+        q.inputs = dense.inputs();
+        q.outputs = dense.outputs();
+        q.weights.resize(q.inputs * q.outputs);
+        q.biases.resize(q.outputs);
+        q.requant.resize(q.outputs);
+
+        bool is_output = (l + 1 == src.size());
+        // Guard against a dead layer (all outputs 0) producing a zero scale
+        float output_scale = is_output ? 1.0f : std::max(max_output[l], 1e-6f) / 255.0f;
+
+        for (std::size_t j = 0; j < q.outputs; ++j) {
+            float max_abs = 0.0f;
+            for (std::size_t i = 0; i < q.inputs; ++i) {
+                max_abs = std::max(max_abs, std::fabs(dense.weights()(i, j)));
+            }
+            float weight_scale = (max_abs > 0.0f) ? max_abs / 127.0f : 1.0f;
+            for (std::size_t i = 0; i < q.inputs; ++i) {
+                long v = std::lround(dense.weights()(i, j) / weight_scale);
+                q.weights[j * q.inputs + i] = static_cast<int8_t>(std::max(-127L, std::min(127L, v)));
+            }
+            float acc_scale = input_scale * weight_scale;
+            q.biases[j] = static_cast<int32_t>(std::lround(dense.biases().data()[j] / acc_scale));
+            q.requant[j] = acc_scale / output_scale;
+        }
+        input_scale = output_scale;
+    }
+}
+
+std::size_t QuantizedNetwork::parameter_bytes() const {
+    std::size_t bytes = 0;
+    for (const Layer& q : layers_) {
+        bytes += q.weights.size() * sizeof(int8_t) + q.biases.size() * sizeof(int32_t) + q.requant.size() * sizeof(float);
+    }
+    return bytes;
+}
+
+void QuantizedNetwork::forward(Span<const unsigned char> pixels, Tensor2D<float>& logits,
+                               QuantizedBuffers& buffers) const {
+    static const RowKernel row_kernel = select_row_kernel();
+
+    std::size_t width = input_size();
+    if (pixels.size() % width != 0) {
+        throw std::invalid_argument("QuantizedNetwork::forward: pixels are not a whole number of images.");
+    }
+    std::size_t num_images = pixels.size() / width;
+    logits.resize(num_images, output_size());
+
+    const unsigned char* x = pixels.data();
+    for (std::size_t l = 0; l < layers_.size(); ++l) {
+        const Layer& q = layers_[l];
+        bool is_output = (l + 1 == layers_.size());
+        std::vector<unsigned char>& y = buffers.activations[l % 2];
+        if (!is_output) {
+            y.resize(num_images * q.outputs);
+        }
+        buffers.accumulators.resize(q.outputs);
+        int32_t* acc = buffers.accumulators.data();
+        for (std::size_t n = 0; n < num_images; ++n) {
+            row_kernel(x + n * q.inputs, q.weights.data(), q.inputs, q.outputs, acc);
+            for (std::size_t j = 0; j < q.outputs; ++j) {
+                float value = static_cast<float>(acc[j] + q.biases[j]) * q.requant[j];
+                if (is_output) {
+                    logits(n, j) = value;
+                } else {
+                    // ReLU and requantization in one clamp to [0, 255]
+                    float clamped = std::min(std::max(value, 0.0f), 255.0f);
+                    y[n * q.outputs + j] = static_cast<unsigned char>(clamped + 0.5f);
+                }
+            }
+        }
+        x = y.data();
+    }
+}
+
+void QuantizedNetwork::predict(Span<const unsigned char> pixels, Span<unsigned char> classes,
+                               QuantizedBuffers& buffers) const {
+    thread_local Tensor2D<float> logits;
+    forward(pixels, logits, buffers);
+    if (classes.size() != logits.rows()) {
+        throw std::invalid_argument("QuantizedNetwork::predict: one class slot per image is required.");
+    }
+    argmax_rows(logits, classes);
+}
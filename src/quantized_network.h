@@ -0,0 +1,59 @@
+#ifndef QUANTIZED_NETWORK_H
+#define QUANTIZED_NETWORK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "neural_network.h"
+#include "span.h"
+#include "tensor.h"
+
+// Scratch for QuantizedNetwork::forward; one per calling thread
+struct QuantizedBuffers {
+    std::vector<unsigned char> activations[2]; // Ping-pong u8 activations between layers
+    std::vector<int32_t> accumulators;         // One sample's int32 sums for the current layer
+};
+
+// Post-training INT8 inference engine.
+//
+// Weights are quantized symmetrically per output channel to int8 (scale = max|w| / 127).
+// Activations are uint8 with zero point 0: the input scale is 1/255, so raw IDX pixels
+// are consumed as-is with no float normalization, and hidden-layer scales come from the
+// largest ReLU output seen on calibration images. Each layer accumulates u8 x s8 products
+// in int32, adds an int32 bias, and requantizes to u8 for the next layer; the last layer
+// is dequantized to float logits. Hidden layers must use ReLU.
+class QuantizedNetwork {
+public:
+    /**
+     * @param network Trained float network (ReLU hidden layers, Identity output).
+     * @param calibration_pixels Raw u8 images (input_size() bytes each) used to pick activation scales.
+     */
+    QuantizedNetwork(const NeuralNetwork& network, Span<const unsigned char> calibration_pixels);
+
+    std::size_t input_size() const { return layers_.front().inputs; }
+    std::size_t output_size() const { return layers_.back().outputs; }
+
+    // Bytes of quantized parameters (int8 weights + int32 biases + float scales)
+    std::size_t parameter_bytes() const;
+
+    // Float logits for pixels.size() / input_size() images, resized into logits
+    void forward(Span<const unsigned char> pixels, Tensor2D<float>& logits, QuantizedBuffers& buffers) const;
+
+    // Argmax class of each image, one entry per image in classes
+    void predict(Span<const unsigned char> pixels, Span<unsigned char> classes, QuantizedBuffers& buffers) const;
+
+private:
+    struct Layer {
+        std::size_t inputs;
+        std::size_t outputs;
+        std::vector<int8_t> weights;   // outputs x inputs (transposed, so each output is a contiguous dot product)
+        std::vector<int32_t> biases;   // In units of input_scale * weight_scale[j]
+        std::vector<float> requant;    // Per output: input_scale * weight_scale[j] / output_scale
+                                       // (last layer: / 1, i.e. dequantize to float)
+    };
+
+    std::vector<Layer> layers_;
+};
+
+#endif // QUANTIZED_NETWORK_H
@@ -0,0 +1,70 @@
+#include "checkpoint.h"
+#include "inference_server.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Scoring daemon: loads a checkpoint and serves it on a Unix domain socket until
+// SIGINT/SIGTERM. See inference_server.h for the wire protocol and `bench loadgen` for a
+// load-generating client.
+//
+// usage: mnist_server [model.ckpt] [--socket path] [--max-batch N] [--max-wait-us N] [--report-s S]
+
+namespace {
+
+InferenceServer* g_server = nullptr;
+
+void handle_signal(int) {
+    if (g_server != nullptr) {
+        g_server->stop();
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        std::string model_path = "mnist_model.ckpt";
+        InferenceServerConfig config;
+        config.report_interval_s = 10.0;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--socket" && i + 1 < argc) {
+                config.socket_path = argv[++i];
+            } else if (arg == "--max-batch" && i + 1 < argc) {
+                config.max_batch = static_cast<std::size_t>(std::atoi(argv[++i]));
+            } else if (arg == "--max-wait-us" && i + 1 < argc) {
+                config.max_wait_us = static_cast<std::size_t>(std::atoi(argv[++i]));
+            } else if (arg == "--report-s" && i + 1 < argc) {
+                config.report_interval_s = std::atof(argv[++i]);
+            } else if (arg[0] != '-') {
+                model_path = arg;
+            } else {
+                std::fprintf(stderr, "usage: mnist_server [model.ckpt] [--socket path] [--max-batch N] "
+                                     "[--max-wait-us N] [--report-s S]\n");
+                return 1;
+            }
+        }
+
+        NeuralNetwork network = Checkpoint::load(model_path);
+        InferenceServer server(network, config);
+        g_server = &server;
+        std::signal(SIGINT, handle_signal);
+        std::signal(SIGTERM, handle_signal);
+
+        std::cout << "Serving " << model_path << " on " << config.socket_path << " (max batch "
+                  << config.max_batch << ", max wait " << config.max_wait_us << " us)" << std::endl;
+        server.run();
+        g_server = nullptr;
+
+        print_server_stats(std::cout, server.take_stats());
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+// Minimal non-owning view over a contiguous run of elements.
+// Stands in for std::span (C++20) so the rest of the project can stay on C++17.
+template <typename T>
+class Span {
+public:
+    using element_type = T;
+    using value_type = typename std::remove_cv<T>::type;
+    using iterator = T*;
+
+    Span() : data_(nullptr), size_(0) {}
+    Span(T* data, std::size_t size) : data_(data), size_(size) {}
+
+    // Allow Span<T> -> Span<const T>
+    template <typename U,
+              typename = typename std::enable_if<std::is_convertible<U (*)[], T (*)[]>::value>::type>
+    Span(const Span<U>& other) : data_(other.data()), size_(other.size()) {}
+
+    // Views over std::vector (const vectors only bind to Span<const T>)
+    template <typename U,
+              typename = typename std::enable_if<std::is_convertible<U (*)[], T (*)[]>::value>::type>
+    Span(std::vector<U>& v) : data_(v.data()), size_(v.size()) {}
+    template <typename U,
+              typename = typename std::enable_if<std::is_convertible<const U (*)[], T (*)[]>::value>::type>
+    Span(const std::vector<U>& v) : data_(v.data()), size_(v.size()) {}
+
+    T* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T& operator[](std::size_t i) const { return data_[i]; }
+
+    iterator begin() const { return data_; }
+    iterator end() const { return data_ + size_; }
+
+    Span subspan(std::size_t offset, std::size_t count) const { return Span(data_ + offset, count); }
+
+private:
+    T* data_;
+    std::size_t size_;
+};
+
+// Read-only span whose element type is not deduced from the argument.
+// Lets templates written as f(ConstSpan<T> in, Span<T> out) deduce T from `out`
+// alone, so callers can pass a Span<T> (or the same span, for in-place use) as `in`.
+template <typename T>
+struct TypeIdentity {
+    using type = T;
+};
+template <typename T>
+using ConstSpan = Span<const typename TypeIdentity<T>::type>;
+
+#endif // SPAN_H
@@ -0,0 +1,157 @@
+#include "sparse_batch.h"
+#include "cpu_features.h"
+
+#if DNN_X86
+#include <immintrin.h>
+#endif
+
+namespace Sparse {
+
+    namespace {
+
+        // Each nonzero x[r][k] scales weight row k into output row r, so the kernels walk
+        // whole rows of W (or G) that are contiguous in memory.
+        template <typename T>
+        void csr_gemm_portable(const BasicSparseBatch<T>& x, const T* w, std::size_t n, T* c) {
+            for (std::size_t r = 0; r < x.rows(); ++r) {
+                BasicSparseRow<T> row = x.row(r);
+                T* out = c + r * n;
+                for (std::size_t k = 0; k < row.nnz; ++k) {
+                    const T v = row.values[k];
+                    const T* wk = w + static_cast<std::size_t>(row.indices[k]) * n;
+                    for (std::size_t j = 0; j < n; ++j) {
+                        out[j] += v * wk[j];
+                    }
+                }
+            }
+        }
+
+        template <typename T>
+        void csr_gemm_tn_portable(const BasicSparseBatch<T>& x, const T* d, std::size_t n, T* g) {
+            for (std::size_t r = 0; r < x.rows(); ++r) {
+                BasicSparseRow<T> row = x.row(r);
+                const T* dr = d + r * n;
+                for (std::size_t k = 0; k < row.nnz; ++k) {
+                    const T v = row.values[k];
+                    T* gk = g + static_cast<std::size_t>(row.indices[k]) * n;
+                    for (std::size_t j = 0; j < n; ++j) {
+                        gk[j] += v * dr[j];
+                    }
+                }
+            }
+        }
+
+#if DNN_X86
+        // 32 output columns stay in four accumulators while every nonzero of the row is
+        // applied, so C is loaded and stored once per block instead of once per nonzero.
+        DNN_TARGET("avx2,fma")
+        void csr_gemm_avx2(const BasicSparseBatch<float>& x, const float* w, std::size_t n, float* c) {
+            for (std::size_t r = 0; r < x.rows(); ++r) {
+                BasicSparseRow<float> row = x.row(r);
+                float* out = c + r * n;
+                std::size_t j = 0;
+                for (; j + 32 <= n; j += 32) {
+                    __m256 c0 = _mm256_loadu_ps(out + j);
+                    __m256 c1 = _mm256_loadu_ps(out + j + 8);
+                    __m256 c2 = _mm256_loadu_ps(out + j + 16);
+                    __m256 c3 = _mm256_loadu_ps(out + j + 24);
+                    for (std::size_t k = 0; k < row.nnz; ++k) {
+                        const __m256 v = _mm256_broadcast_ss(row.values + k);
+                        const float* wk = w + static_cast<std::size_t>(row.indices[k]) * n + j;
+                        c0 = _mm256_fmadd_ps(v, _mm256_loadu_ps(wk), c0);
+                        c1 = _mm256_fmadd_ps(v, _mm256_loadu_ps(wk + 8), c1);
+                        c2 = _mm256_fmadd_ps(v, _mm256_loadu_ps(wk + 16), c2);
+                        c3 = _mm256_fmadd_ps(v, _mm256_loadu_ps(wk + 24), c3);
+                    }
+                    _mm256_storeu_ps(out + j, c0);
+                    _mm256_storeu_ps(out + j + 8, c1);
+                    _mm256_storeu_ps(out + j + 16, c2);
+                    _mm256_storeu_ps(out + j + 24, c3);
+                }
+                for (; j + 8 <= n; j += 8) {
+                    __m256 c0 = _mm256_loadu_ps(out + j);
+                    for (std::size_t k = 0; k < row.nnz; ++k) {
+                        const float* wk = w + static_cast<std::size_t>(row.indices[k]) * n + j;
+                        c0 = _mm256_fmadd_ps(_mm256_broadcast_ss(row.values + k), _mm256_loadu_ps(wk), c0);
+                    }
+                    _mm256_storeu_ps(out + j, c0);
+                }
+                for (; j < n; ++j) {
+                    float sum = out[j];
+                    for (std::size_t k = 0; k < row.nnz; ++k) {
+                        sum += row.values[k] * w[static_cast<std::size_t>(row.indices[k]) * n + j];
+                    }
+                    out[j] = sum;
+                }
+            }
+        }
+
+        // The transposed product keeps 32 columns of D's row in registers and updates the
+        // matching slice of each touched gradient row.
+        DNN_TARGET("avx2,fma")
+        void csr_gemm_tn_avx2(const BasicSparseBatch<float>& x, const float* d, std::size_t n, float* g) {
+            for (std::size_t r = 0; r < x.rows(); ++r) {
+                BasicSparseRow<float> row = x.row(r);
+                const float* dr = d + r * n;
+                std::size_t j = 0;
+                for (; j + 32 <= n; j += 32) {
+                    const __m256 d0 = _mm256_loadu_ps(dr + j);
+                    const __m256 d1 = _mm256_loadu_ps(dr + j + 8);
+                    const __m256 d2 = _mm256_loadu_ps(dr + j + 16);
+                    const __m256 d3 = _mm256_loadu_ps(dr + j + 24);
+                    for (std::size_t k = 0; k < row.nnz; ++k) {
+                        const __m256 v = _mm256_broadcast_ss(row.values + k);
+                        float* gk = g + static_cast<std::size_t>(row.indices[k]) * n + j;
+                        _mm256_storeu_ps(gk, _mm256_fmadd_ps(v, d0, _mm256_loadu_ps(gk)));
+                        _mm256_storeu_ps(gk + 8, _mm256_fmadd_ps(v, d1, _mm256_loadu_ps(gk + 8)));
+                        _mm256_storeu_ps(gk + 16, _mm256_fmadd_ps(v, d2, _mm256_loadu_ps(gk + 16)));
+                        _mm256_storeu_ps(gk + 24, _mm256_fmadd_ps(v, d3, _mm256_loadu_ps(gk + 24)));
+                    }
+                }
+                for (; j + 8 <= n; j += 8) {
+                    const __m256 d0 = _mm256_loadu_ps(dr + j);
+                    for (std::size_t k = 0; k < row.nnz; ++k) {
+                        float* gk = g + static_cast<std::size_t>(row.indices[k]) * n + j;
+                        _mm256_storeu_ps(gk, _mm256_fmadd_ps(_mm256_broadcast_ss(row.values + k), d0, _mm256_loadu_ps(gk)));
+                    }
+                }
+                for (; j < n; ++j) {
+                    for (std::size_t k = 0; k < row.nnz; ++k) {
+                        g[static_cast<std::size_t>(row.indices[k]) * n + j] += row.values[k] * dr[j];
+                    }
+                }
+            }
+        }
+#endif
+
+    } // namespace
+
+    void csr_gemm(const BasicSparseBatch<float>& x, const float* w, std::size_t n, float* c) {
+#if DNN_X86
+        if (CpuFeatures::has_avx2() && CpuFeatures::has_fma()) {
+            csr_gemm_avx2(x, w, n, c);
+            return;
+        }
+#endif
+        csr_gemm_portable(x, w, n, c);
+    }
+
+    void csr_gemm(const BasicSparseBatch<double>& x, const double* w, std::size_t n, double* c) {
+        csr_gemm_portable(x, w, n, c);
+    }
+
+    void csr_gemm_tn(const BasicSparseBatch<float>& x, const float* d, std::size_t n, float* g) {
+#if DNN_X86
+        if (CpuFeatures::has_avx2() && CpuFeatures::has_fma()) {
+            csr_gemm_tn_avx2(x, d, n, g);
+            return;
+        }
+#endif
+        csr_gemm_tn_portable(x, d, n, g);
+    }
+
+    void csr_gemm_tn(const BasicSparseBatch<double>& x, const double* d, std::size_t n, double* g) {
+        csr_gemm_tn_portable(x, d, n, g);
+    }
+
+} // namespace Sparse
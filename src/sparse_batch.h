@@ -0,0 +1,133 @@
+#ifndef SPARSE_BATCH_H
+#define SPARSE_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "tensor.h"
+
+// Nonzero entries of one row of a BasicSparseBatch
+template <typename T>
+struct BasicSparseRow {
+    const uint32_t* indices; // Ascending column indices
+    const T* values;
+    std::size_t nnz;
+};
+
+// Mini-batch in compressed sparse row (CSR) form: one sample per row, only the nonzero
+// inputs stored. MNIST pixels are ~80% exact zeros, so a first layer fed this form can
+// skip most of its weight rows. Rows are appended in order with push() / end_row();
+// clear() keeps the capacity, so a batch reused across steps stops allocating once it
+// has seen its largest size (or after reserve()).
+template <typename T>
+class BasicSparseBatch {
+public:
+    BasicSparseBatch() : cols_(0) { offsets_.push_back(0); }
+
+    // Drops every row and sets the dense width
+    void clear(std::size_t cols) {
+        cols_ = cols;
+        offsets_.resize(1);
+        indices_.clear();
+        values_.clear();
+    }
+
+    void reserve(std::size_t rows, std::size_t nnz) {
+        offsets_.reserve(rows + 1);
+        indices_.reserve(nnz);
+        values_.reserve(nnz);
+    }
+
+    // Adds a nonzero to the current row; columns must be pushed in ascending order
+    void push(uint32_t col, T value) {
+        indices_.push_back(col);
+        values_.push_back(value);
+    }
+
+    // Closes the current row (an empty row is an all-zero sample)
+    void end_row() { offsets_.push_back(static_cast<uint32_t>(indices_.size())); }
+
+    // Appends a row given in sparse form, e.g. a row of another batch
+    void append_row(const BasicSparseRow<T>& row) {
+        indices_.insert(indices_.end(), row.indices, row.indices + row.nnz);
+        values_.insert(values_.end(), row.values, row.values + row.nnz);
+        end_row();
+    }
+
+    // Appends a dense row of cols() values, keeping its nonzeros
+    void append_dense_row(const T* row) {
+        for (std::size_t c = 0; c < cols_; ++c) {
+            if (row[c] != T(0)) {
+                push(static_cast<uint32_t>(c), row[c]);
+            }
+        }
+        end_row();
+    }
+
+    std::size_t rows() const { return offsets_.size() - 1; }
+    std::size_t cols() const { return cols_; }
+    std::size_t nnz() const { return indices_.size(); }
+
+    // Fraction of entries stored, in [0, 1]
+    double density() const {
+        std::size_t total = rows() * cols_;
+        return total == 0 ? 0.0 : static_cast<double>(nnz()) / static_cast<double>(total);
+    }
+
+    BasicSparseRow<T> row(std::size_t r) const {
+        return BasicSparseRow<T>{indices_.data() + offsets_[r], values_.data() + offsets_[r],
+                                 static_cast<std::size_t>(offsets_[r + 1] - offsets_[r])};
+    }
+
+    const uint32_t* offsets() const { return offsets_.data(); } // rows() + 1 entries
+    const uint32_t* indices() const { return indices_.data(); }
+    const T* values() const { return values_.data(); }
+
+    // Expands into a dense rows() x cols() tensor
+    void to_dense(Tensor2D<T>& out) const {
+        out.resize(rows(), cols_);
+        out.fill(T(0));
+        for (std::size_t r = 0; r < rows(); ++r) {
+            T* dst = out.data() + r * cols_;
+            for (uint32_t k = offsets_[r]; k < offsets_[r + 1]; ++k) {
+                dst[indices_[k]] = values_[k];
+            }
+        }
+    }
+
+private:
+    std::size_t cols_;
+    std::vector<uint32_t> offsets_; // Row r holds entries [offsets_[r], offsets_[r + 1])
+    std::vector<uint32_t> indices_;
+    std::vector<T> values_;
+};
+
+typedef BasicSparseRow<float> SparseRow;
+typedef BasicSparseBatch<float> SparseBatch;
+
+// Products with a CSR left operand, for a first layer fed sparse inputs
+namespace Sparse {
+
+    // Above this density the dense GEMM path is faster than the sparse kernels (measured
+    // with `bench sparse` on a 784-128 layer; MNIST batches sit around 0.19)
+    const double kMaxDensity = 0.5;
+
+    /**
+     * @brief C += X * W, X sparse (rows x K), W dense K x N row-major, C rows x N.
+     * Only the weight rows of nonzero inputs are read.
+     */
+    void csr_gemm(const BasicSparseBatch<float>& x, const float* w, std::size_t n, float* c);
+    void csr_gemm(const BasicSparseBatch<double>& x, const double* w, std::size_t n, double* c);
+
+    /**
+     * @brief G += X^T * D, X sparse (rows x K), D dense rows x N, G dense K x N.
+     * Only the gradient rows of nonzero inputs are touched.
+     */
+    void csr_gemm_tn(const BasicSparseBatch<float>& x, const float* d, std::size_t n, float* g);
+    void csr_gemm_tn(const BasicSparseBatch<double>& x, const double* d, std::size_t n, double* g);
+
+} // namespace Sparse
+
+#endif // SPARSE_BATCH_H
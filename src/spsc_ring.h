@@ -0,0 +1,105 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Capacity is rounded up to a power of two. head_ and tail_ sit on separate cache
+// lines so the two threads do not false-share.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity) : head_(0), tail_(0) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const { return slots_.size(); }
+
+    // Producer side. Returns false if the ring is full.
+    bool try_push(const T& value) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+            return false;
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty.
+    bool try_pop(T& out) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> slots_;
+    std::size_t mask_;
+    alignas(64) std::atomic<std::size_t> head_; // Next slot to pop, written by the consumer
+    alignas(64) std::atomic<std::size_t> tail_; // Next slot to push, written by the producer
+};
+
+// Lets a thread block on the state of an SpscRing instead of polling it.
+// The ring stays lock-free: notify() costs a fence and a load unless someone is asleep, and
+// the mutex is only taken to sleep and to wake a sleeper.
+class RingSignal {
+public:
+    RingSignal() : sleepers_(0) {}
+
+    // Returns once ready() holds. ready() is retried a few times first, since the other side
+    // is usually about to hand over, then the caller sleeps until notify().
+    template <typename Ready>
+    void wait(Ready ready) {
+        for (int i = 0; i < kSpins; ++i) {
+            if (ready()) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Announce the sleeper before the final check of ready(); pairs with the fence in notify()
+        sleepers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cv_.wait(lock, ready);
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Call after every change that can make a waiter's ready() true. The two fences make
+    // either this call see the sleeper or the sleeper's check see the change. A sleeper
+    // holds the mutex from its announcement until it is waiting, so taking the mutex here
+    // means the wake-up cannot arrive before it sleeps.
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        cv_.notify_all();
+    }
+
+private:
+    static const int kSpins = 16;
+    std::atomic<int> sleepers_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+#endif // SPSC_RING_H
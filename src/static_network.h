@@ -0,0 +1,192 @@
+#ifndef STATIC_NETWORK_H
+#define STATIC_NETWORK_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "activation_functions.h"
+#include "cpu_features.h"
+#include "neural_network.h"
+
+// Fully connected network whose topology is fixed at compile time, for single-sample scoring.
+//
+//   StaticNetwork<Activations::Kind::ReLU, 784, 128, 64, 10> model(trained_network);
+//   model.forward(input, logits);
+//
+// Every layer stores its weights (inputs x outputs, as in DenseLayer) and biases in
+// std::array members, so the whole model is one object with no heap indirection and
+// forward() allocates nothing: activations live in fixed-size stack arrays. All loop trip
+// counts are template constants, which lets the compiler unroll and vectorize them without
+// remainder handling. The last layer is Identity, as in NeuralNetwork.
+//
+// The parameters make the object large (about 400 KB for 784-128-10); allocate it on the
+// heap or as a static rather than on a thread's stack.
+
+namespace StaticLayers {
+
+    template <Activations::Kind K>
+    inline float activate(float z) {
+        if (K == Activations::Kind::ReLU) {
+            return z > 0.0f ? z : 0.0f;
+        } else if (K == Activations::Kind::Sigmoid) {
+            return 1.0f / (1.0f + std::exp(-z));
+        } else if (K == Activations::Kind::Tanh) {
+            return std::tanh(z);
+        }
+        return z;
+    }
+
+    // out = f(in * W + b) for one sample, accumulated row by row of W so the inner loop is a
+    // contiguous axpy of length Out
+    template <std::size_t In, std::size_t Out, Activations::Kind K>
+    inline __attribute__((always_inline)) void dense(const float* weights, const float* biases, const float* in, float* out) {
+        alignas(64) float acc[Out];
+        for (std::size_t j = 0; j < Out; ++j) {
+            acc[j] = biases[j];
+        }
+        for (std::size_t i = 0; i < In; ++i) {
+            const float x = in[i];
+            const float* w = weights + i * Out;
+            for (std::size_t j = 0; j < Out; ++j) {
+                acc[j] += x * w[j];
+            }
+        }
+        for (std::size_t j = 0; j < Out; ++j) {
+            out[j] = activate<K>(acc[j]);
+        }
+    }
+
+#if DNN_X86
+    // The same loops compiled for AVX2+FMA; selected at runtime. dense() uses only the
+    // baseline ISA, so it inlines here and is vectorized for the wider target.
+    template <std::size_t In, std::size_t Out, Activations::Kind K>
+    DNN_TARGET("avx2,fma") void dense_avx2(const float* weights, const float* biases, const float* in, float* out) {
+        dense<In, Out, K>(weights, biases, in, out);
+    }
+#endif
+
+    // One layer's parameters
+    template <std::size_t In, std::size_t Out, Activations::Kind K>
+    struct Dense {
+        static constexpr std::size_t inputs = In;
+        static constexpr std::size_t outputs = Out;
+        static constexpr Activations::Kind activation = K;
+
+        alignas(64) std::array<float, In * Out> weights;
+        alignas(64) std::array<float, Out> biases;
+
+        void forward(const float* in, float* out, bool use_avx2) const {
+#if DNN_X86
+            if (use_avx2) {
+                dense_avx2<In, Out, K>(weights.data(), biases.data(), in, out);
+                return;
+            }
+#endif
+            (void)use_avx2;
+            dense<In, Out, K>(weights.data(), biases.data(), in, out);
+        }
+
+        void load(const DenseLayer& layer, std::size_t index) {
+            if (layer.inputs() != In || layer.outputs() != Out || layer.activation() != K) {
+                throw std::invalid_argument("StaticNetwork: layer " + std::to_string(index) + " is " +
+                                            std::to_string(layer.inputs()) + "x" + std::to_string(layer.outputs()) +
+                                            " " + Activations::kind_name(layer.activation()) + ", expected " +
+                                            std::to_string(In) + "x" + std::to_string(Out) + " " +
+                                            Activations::kind_name(K) + ".");
+            }
+            std::memcpy(weights.data(), layer.weights().data(), sizeof(weights));
+            std::memcpy(biases.data(), layer.biases().data(), sizeof(biases));
+        }
+    };
+
+    // Recursive chain of layers: In -> Out -> Rest...
+    template <Activations::Kind Hidden, std::size_t In, std::size_t Out, std::size_t... Rest>
+    struct Chain {
+        static constexpr std::size_t output_size = Chain<Hidden, Out, Rest...>::output_size;
+
+        Dense<In, Out, Hidden> layer;
+        Chain<Hidden, Out, Rest...> next;
+
+        void forward(const float* in, float* logits, bool use_avx2) const {
+            alignas(64) float hidden[Out];
+            layer.forward(in, hidden, use_avx2);
+            next.forward(hidden, logits, use_avx2);
+        }
+
+        void load(const std::vector<DenseLayer>& layers, std::size_t index) {
+            layer.load(layers[index], index);
+            next.load(layers, index + 1);
+        }
+    };
+
+    template <Activations::Kind Hidden, std::size_t In, std::size_t Out>
+    struct Chain<Hidden, In, Out> {
+        static constexpr std::size_t output_size = Out;
+
+        Dense<In, Out, Activations::Kind::Identity> layer;
+
+        void forward(const float* in, float* logits, bool use_avx2) const {
+            layer.forward(in, logits, use_avx2);
+        }
+
+        void load(const std::vector<DenseLayer>& layers, std::size_t index) {
+            layer.load(layers[index], index);
+        }
+    };
+
+} // namespace StaticLayers
+
+template <Activations::Kind Hidden, std::size_t Input, std::size_t... Sizes>
+class StaticNetwork {
+    static_assert(sizeof...(Sizes) >= 1, "StaticNetwork needs at least an input and an output size");
+
+public:
+    static constexpr std::size_t input_size = Input;
+    static constexpr std::size_t output_size = StaticLayers::Chain<Hidden, Input, Sizes...>::output_size;
+    static constexpr std::size_t num_layers = sizeof...(Sizes);
+
+    typedef std::array<float, input_size> InputArray;
+    typedef std::array<float, output_size> OutputArray;
+
+    // All parameters zero
+    StaticNetwork() : chain_(), use_avx2_(CpuFeatures::has_avx2() && CpuFeatures::has_fma()) {
+    }
+
+    // Copies the parameters of a trained network. Throws std::invalid_argument if its
+    // layer sizes or activations differ from the template's.
+    explicit StaticNetwork(const NeuralNetwork& network) : StaticNetwork() {
+        if (network.num_layers() != num_layers) {
+            throw std::invalid_argument("StaticNetwork: expected " + std::to_string(num_layers) + " layers, network has " +
+                                        std::to_string(network.num_layers()) + ".");
+        }
+        chain_.load(network.layers(), 0);
+    }
+
+    // logits = network(input) for one sample. Allocation-free.
+    void forward(const float* input, float* logits) const {
+        chain_.forward(input, logits, use_avx2_);
+    }
+
+    void forward(const InputArray& input, OutputArray& logits) const {
+        forward(input.data(), logits.data());
+    }
+
+    // Index of the largest logit
+    std::size_t predict(const float* input) const {
+        OutputArray logits;
+        forward(input, logits.data());
+        return static_cast<std::size_t>(std::max_element(logits.begin(), logits.end()) - logits.begin());
+    }
+
+private:
+    StaticLayers::Chain<Hidden, Input, Sizes...> chain_;
+    bool use_avx2_;
+};
+
+#endif // STATIC_NETWORK_H
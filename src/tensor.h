@@ -0,0 +1,128 @@
+#ifndef TENSOR_H
+#define TENSOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "span.h"
+
+// Row-major 2D tensor with a 64-byte aligned, contiguous buffer.
+// Used for mini-batches (one sample per row) and weight matrices.
+// resize() only reallocates when the new shape needs more capacity, so a tensor
+// reused across steps does not touch the heap after warm-up. attach() points the tensor at
+// external storage (e.g. a Workspace slice) that it uses but never frees.
+template <typename T>
+class Tensor2D {
+public:
+    static constexpr std::size_t kAlignment = 64;
+
+    Tensor2D() : data_(nullptr), rows_(0), cols_(0), capacity_(0), owned_(true) {}
+
+    // Allocates rows x cols elements, zero-initialized
+    Tensor2D(std::size_t rows, std::size_t cols) : Tensor2D() {
+        resize(rows, cols);
+        fill(T(0));
+    }
+
+    ~Tensor2D() { deallocate(); }
+
+    Tensor2D(const Tensor2D& other) : Tensor2D() {
+        resize(other.rows_, other.cols_);
+        std::copy(other.data_, other.data_ + other.size(), data_);
+    }
+
+    Tensor2D& operator=(const Tensor2D& other) {
+        if (this != &other) {
+            resize(other.rows_, other.cols_);
+            std::copy(other.data_, other.data_ + other.size(), data_);
+        }
+        return *this;
+    }
+
+    Tensor2D(Tensor2D&& other) noexcept
+        : data_(other.data_), rows_(other.rows_), cols_(other.cols_), capacity_(other.capacity_), owned_(other.owned_) {
+        other.data_ = nullptr;
+        other.rows_ = other.cols_ = other.capacity_ = 0;
+        other.owned_ = true;
+    }
+
+    Tensor2D& operator=(Tensor2D&& other) noexcept {
+        if (this != &other) {
+            deallocate();
+            data_ = other.data_;
+            rows_ = other.rows_;
+            cols_ = other.cols_;
+            capacity_ = other.capacity_;
+            owned_ = other.owned_;
+            other.data_ = nullptr;
+            other.rows_ = other.cols_ = other.capacity_ = 0;
+            other.owned_ = true;
+        }
+        return *this;
+    }
+
+    // Changes the shape. Contents are unspecified afterwards.
+    void resize(std::size_t rows, std::size_t cols) {
+        std::size_t needed = rows * cols;
+        if (needed > capacity_) {
+            deallocate();
+            data_ = static_cast<T*>(::operator new(needed * sizeof(T), std::align_val_t(kAlignment)));
+            capacity_ = needed;
+            owned_ = true;
+        }
+        rows_ = rows;
+        cols_ = cols;
+    }
+
+    // Uses `capacity` elements at `data` as storage, shaped 0 x 0 until resized. The memory
+    // must outlive the tensor (or the next attach/resize past capacity, which reverts to
+    // owned heap storage).
+    void attach(T* data, std::size_t capacity) {
+        deallocate();
+        data_ = data;
+        capacity_ = capacity;
+        owned_ = false;
+        rows_ = cols_ = 0;
+    }
+
+    void fill(T value) { std::fill(data_, data_ + size(), value); }
+
+    std::size_t rows() const { return rows_; }
+    std::size_t cols() const { return cols_; }
+    std::size_t size() const { return rows_ * cols_; }
+    bool empty() const { return size() == 0; }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+
+    T& operator()(std::size_t r, std::size_t c) { return data_[r * cols_ + c]; }
+    const T& operator()(std::size_t r, std::size_t c) const { return data_[r * cols_ + c]; }
+
+    Span<T> row(std::size_t r) { return Span<T>(data_ + r * cols_, cols_); }
+    Span<const T> row(std::size_t r) const { return Span<const T>(data_ + r * cols_, cols_); }
+
+    Span<T> flat() { return Span<T>(data_, size()); }
+    Span<const T> flat() const { return Span<const T>(data_, size()); }
+
+private:
+    void deallocate() {
+        if (data_ != nullptr && owned_) {
+            ::operator delete(data_, std::align_val_t(kAlignment));
+        }
+        data_ = nullptr;
+        capacity_ = 0;
+    }
+
+    T* data_;
+    std::size_t rows_;
+    std::size_t cols_;
+    std::size_t capacity_;
+    bool owned_; // False when attached to external storage
+};
+
+// A mini-batch or full dataset of flattened images: N rows x (rows * cols) pixels
+using Batch = Tensor2D<float>;
+
+#endif // TENSOR_H
@@ -0,0 +1,91 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(std::size_t num_threads)
+    : task_(nullptr), context_(nullptr), generation_(0), pending_(0), stopping_(false) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(num_threads - 1);
+    for (std::size_t i = 1; i < num_threads; ++i) {
+        workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_cv_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run_task(TaskFn fn, const void* context) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = fn;
+        context_ = context;
+        pending_ = workers_.size();
+        error_ = nullptr;
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    // The calling thread is worker 0
+    std::exception_ptr caller_error;
+    try {
+        fn(context, 0);
+    } catch (...) {
+        caller_error = std::current_exception();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this]() { return pending_ == 0; });
+    task_ = nullptr;
+    context_ = nullptr;
+    std::exception_ptr error = caller_error ? caller_error : error_;
+    lock.unlock();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::worker_loop(std::size_t index) {
+    std::size_t seen_generation = 0;
+    for (;;) {
+        TaskFn task = nullptr;
+        const void* context = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [&]() { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) {
+                return;
+            }
+            seen_generation = generation_;
+            task = task_;
+            context = context_;
+        }
+
+        std::exception_ptr error;
+        try {
+            task(context, index);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (error && !error_) {
+                error_ = error;
+            }
+            if (--pending_ == 0) {
+                done_cv_.notify_one();
+            }
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of persistent worker threads for fork/join parallel loops.
+// run(fn) calls fn(t) exactly once for every t in [0, size()) and returns when all
+// calls have finished. Task t always runs on the same thread (task 0 on the caller),
+// so per-task state stays in one core's cache across steps.
+class ThreadPool {
+public:
+    // num_threads == 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(std::size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const { return workers_.size() + 1; }
+
+    // Not reentrant: fn must not call run() on the same pool.
+    // If a task throws, the first exception is rethrown here after all tasks finish.
+    // fn is called through a plain pointer rather than wrapped in std::function, so
+    // dispatching a step never allocates.
+    template <typename Fn>
+    void run(const Fn& fn) {
+        run_task(&invoke<Fn>, &fn);
+    }
+
+private:
+    typedef void (*TaskFn)(const void* context, std::size_t t);
+
+    template <typename Fn>
+    static void invoke(const void* context, std::size_t t) {
+        (*static_cast<const Fn*>(context))(t);
+    }
+
+    void run_task(TaskFn fn, const void* context);
+    void worker_loop(std::size_t index);
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    TaskFn task_;
+    const void* context_;
+    std::size_t generation_;
+    std::size_t pending_;
+    bool stopping_;
+    std::exception_ptr error_;
+};
+
+#endif // THREAD_POOL_H
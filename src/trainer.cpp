@@ -0,0 +1,211 @@
+#include "trainer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+void add_into(Tensor2D<float>& dst, const Tensor2D<float>& src) {
+    float* d = dst.data();
+    const float* s = src.data();
+    for (std::size_t i = 0; i < dst.size(); ++i) {
+        d[i] += s[i];
+    }
+}
+
+} // namespace
+
+Trainer::Trainer(NeuralNetwork& network, SgdOptimizer& optimizer, const TrainerConfig& config)
+    : network_(network), optimizer_(optimizer), config_(config), pool_(config.num_threads), rng_(config.seed) {
+    if (config_.batch_size == 0) {
+        throw std::invalid_argument("Trainer: batch_size must be non-zero.");
+    }
+    workers_.resize(pool_.size());
+    const std::size_t width = network_.input_size();
+    const std::size_t max_shard = (config_.batch_size + workers_.size() - 1) / workers_.size();
+    for (Worker& worker : workers_) {
+        worker.grads = network_.make_gradients();
+        worker.workspace.reserve(Workspace::bytes_for<float>(max_shard * width) + network_.workspace_bytes(max_shard));
+        worker.input.attach(worker.workspace.allocate<float>(max_shard * width), max_shard * width);
+        network_.bind_buffers(worker.buffers, worker.workspace, max_shard);
+        worker.sparse_input.reserve(max_shard, max_shard * width);
+        worker.labels.reserve(max_shard);
+    }
+}
+
+template <typename Source>
+double Trainer::run_step(std::size_t batch_rows, const Source& source, std::size_t* correct) {
+    const std::size_t num_workers = workers_.size();
+    const std::size_t width = network_.input_size();
+
+    pool_.run([&](std::size_t t) {
+        Worker& worker = workers_[t];
+        std::size_t begin = t * batch_rows / num_workers;
+        std::size_t end = (t + 1) * batch_rows / num_workers;
+        worker.loss = 0.0;
+        worker.correct = 0;
+        for (LayerGradients& g : worker.grads) {
+            g.zero();
+        }
+        if (begin == end) {
+            return;
+        }
+
+        worker.labels.resize(end - begin);
+        for (std::size_t i = begin; i < end; ++i) {
+            worker.labels[i - begin] = source.label(i);
+        }
+
+        float fraction = static_cast<float>(end - begin) / static_cast<float>(batch_rows);
+        double shard_loss;
+        if constexpr (std::is_same<decltype(source.row(0)), SparseRow>::value) {
+            worker.sparse_input.clear(width);
+            for (std::size_t i = begin; i < end; ++i) {
+                worker.sparse_input.append_row(source.row(i));
+            }
+            shard_loss = network_.compute_gradients(worker.sparse_input, worker.labels, fraction,
+                                                    worker.buffers, worker.grads, &worker.correct);
+        } else {
+            worker.input.resize(end - begin, width);
+            for (std::size_t i = begin; i < end; ++i) {
+                const float* row = source.row(i);
+                std::copy(row, row + width, worker.input.data() + (i - begin) * width);
+            }
+            shard_loss = network_.compute_gradients(worker.input, worker.labels, fraction,
+                                                    worker.buffers, worker.grads, &worker.correct);
+        }
+        worker.loss = shard_loss * static_cast<double>(end - begin);
+    });
+
+    reduce_gradients();
+    optimizer_.step(network_, workers_[0].grads);
+
+    double loss_sum = 0.0;
+    for (const Worker& worker : workers_) {
+        loss_sum += worker.loss;
+        if (correct != nullptr) {
+            *correct += worker.correct;
+        }
+    }
+    return loss_sum / static_cast<double>(batch_rows);
+}
+
+void Trainer::reduce_gradients() {
+    const std::size_t n = workers_.size();
+    for (std::size_t stride = 1; stride < n; stride *= 2) {
+        pool_.run([&](std::size_t t) {
+            if (t % (2 * stride) != 0 || t + stride >= n) {
+                return;
+            }
+            std::vector<LayerGradients>& dst = workers_[t].grads;
+            const std::vector<LayerGradients>& src = workers_[t + stride].grads;
+            for (std::size_t l = 0; l < dst.size(); ++l) {
+                add_into(dst[l].weights, src[l].weights);
+                add_into(dst[l].biases, src[l].biases);
+            }
+        });
+    }
+}
+
+double Trainer::train_batch(const Tensor2D<float>& inputs, Span<const unsigned char> labels, std::size_t* correct) {
+    if (inputs.cols() != network_.input_size() || labels.size() != inputs.rows()) {
+        throw std::invalid_argument("Trainer::train_batch: batch shape does not match the network.");
+    }
+    if (inputs.rows() == 0) {
+        return 0.0;
+    }
+    struct {
+        const Tensor2D<float>* inputs;
+        Span<const unsigned char> labels;
+        const float* row(std::size_t i) const { return inputs->data() + i * inputs->cols(); }
+        unsigned char label(std::size_t i) const { return labels[i]; }
+    } source = {&inputs, labels};
+    return run_step(inputs.rows(), source, correct);
+}
+
+double Trainer::train_batch(const SparseBatch& inputs, Span<const unsigned char> labels, std::size_t* correct) {
+    if (inputs.cols() != network_.input_size() || labels.size() != inputs.rows()) {
+        throw std::invalid_argument("Trainer::train_batch: batch shape does not match the network.");
+    }
+    if (inputs.rows() == 0) {
+        return 0.0;
+    }
+    struct {
+        const SparseBatch* inputs;
+        Span<const unsigned char> labels;
+        SparseRow row(std::size_t i) const { return inputs->row(i); }
+        unsigned char label(std::size_t i) const { return labels[i]; }
+    } source = {&inputs, labels};
+    return run_step(inputs.rows(), source, correct);
+}
+
+EpochStats Trainer::train_epoch(const Batch& images, Span<const unsigned char> labels) {
+    if (images.cols() != network_.input_size() || labels.size() != images.rows()) {
+        throw std::invalid_argument("Trainer::train_epoch: dataset shape does not match the network.");
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    order_.resize(images.rows());
+    std::iota(order_.begin(), order_.end(), 0u);
+    std::shuffle(order_.begin(), order_.end(), rng_);
+
+    EpochStats stats;
+    double loss_sum = 0.0;
+    std::size_t correct = 0;
+    for (std::size_t offset = 0; offset < images.rows(); offset += config_.batch_size) {
+        std::size_t rows = std::min(config_.batch_size, images.rows() - offset);
+        struct {
+            const Batch* images;
+            Span<const unsigned char> labels;
+            const uint32_t* order;
+            const float* row(std::size_t i) const { return images->data() + order[i] * images->cols(); }
+            unsigned char label(std::size_t i) const { return labels[order[i]]; }
+        } source = {&images, labels, order_.data() + offset};
+        loss_sum += run_step(rows, source, &correct) * static_cast<double>(rows);
+    }
+
+    stats.samples = images.rows();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats.samples > 0) {
+        stats.mean_loss = loss_sum / static_cast<double>(stats.samples);
+        stats.accuracy = static_cast<double>(correct) / static_cast<double>(stats.samples);
+        stats.samples_per_second = static_cast<double>(stats.samples) / stats.seconds;
+    }
+    return stats;
+}
+
+EpochStats Trainer::train_epoch(DataLoader& loader) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    EpochStats stats;
+    double loss_sum = 0.0;
+    std::size_t correct = 0;
+    while (const LoaderBatch* batch = loader.next()) {
+        double loss;
+        try {
+            loss = loader.sparse() ? train_batch(batch->sparse, batch->labels, &correct)
+                                   : train_batch(batch->images, batch->labels, &correct);
+        } catch (...) {
+            // Hand the slot back, or the loader thread waits for it forever on the next epoch
+            loader.release(batch);
+            throw;
+        }
+        loss_sum += loss * static_cast<double>(batch->labels.size());
+        stats.samples += batch->labels.size();
+        loader.release(batch);
+    }
+
+    LoaderStats loader_stats = loader.take_stats();
+    stats.loader_wait_seconds = loader_stats.wait_seconds;
+    stats.loader_stalls = loader_stats.stalls;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats.samples > 0) {
+        stats.mean_loss = loss_sum / static_cast<double>(stats.samples);
+        stats.accuracy = static_cast<double>(correct) / static_cast<double>(stats.samples);
+        stats.samples_per_second = static_cast<double>(stats.samples) / stats.seconds;
+    }
+    return stats;
+}
@@ -0,0 +1,96 @@
+#ifndef TRAINER_H
+#define TRAINER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "data_loader.h"
+#include "neural_network.h"
+#include "optimizer.h"
+#include "sparse_batch.h"
+#include "span.h"
+#include "tensor.h"
+#include "thread_pool.h"
+#include "workspace.h"
+
+struct TrainerConfig {
+    std::size_t batch_size = 64;
+    std::size_t num_threads = 0; // 0 = one per hardware thread
+    uint32_t seed = 1;           // Seeds the per-epoch shuffle
+};
+
+struct EpochStats {
+    double mean_loss = 0.0;
+    double accuracy = 0.0; // Training accuracy measured during the epoch (before each update)
+    std::size_t samples = 0;
+    double seconds = 0.0;
+    double samples_per_second = 0.0;
+    double loader_wait_seconds = 0.0; // Time the training thread spent waiting for input
+    std::size_t loader_stalls = 0;    // Batches that were not ready when requested
+};
+
+// Data-parallel mini-batch trainer.
+// Each mini-batch is cut into one contiguous shard per thread. Every worker runs the
+// forward/backward pass for its shard into its own gradient buffers, then the buffers
+// are summed with a fixed pairwise tree (0+1, 2+3, ..., then 0+2, ...). Shard boundaries
+// and summation order depend only on the batch and thread count, so results are
+// bit-reproducible for a given thread count.
+class Trainer {
+public:
+    Trainer(NeuralNetwork& network, SgdOptimizer& optimizer, const TrainerConfig& config);
+
+    std::size_t num_threads() const { return pool_.size(); }
+    const TrainerConfig& config() const { return config_; }
+
+    /**
+     * @brief One optimizer step on an already assembled batch.
+     * @param correct If non-null, incremented by the rows predicted correctly before the update.
+     * @return Mean loss over the batch.
+     */
+    double train_batch(const Tensor2D<float>& inputs, Span<const unsigned char> labels, std::size_t* correct);
+
+    // Same for a sparse batch; the input layer uses the sparse kernel while the batch is sparse enough
+    double train_batch(const SparseBatch& inputs, Span<const unsigned char> labels, std::size_t* correct);
+
+    // One pass over the dataset in a freshly shuffled order, in batches of config().batch_size
+    EpochStats train_epoch(const Batch& images, Span<const unsigned char> labels);
+
+    // One epoch from a prefetching loader: trains on batches until loader.next() returns nullptr.
+    // Shuffling, batch size and dense or sparse input come from the loader's configuration.
+    // If training a batch throws, the batch is released to the loader before the exception
+    // propagates, so the loader stays usable.
+    EpochStats train_epoch(DataLoader& loader);
+
+private:
+    // All per-step tensors of a worker live in its workspace, sized once for the largest
+    // shard, so a steady-state step makes no heap allocations.
+    struct Worker {
+        Workspace workspace;
+        Tensor2D<float> input;
+        SparseBatch sparse_input; // Shard of a sparse batch; reserved for a fully dense shard
+        std::vector<unsigned char> labels;
+        PassBuffers buffers;
+        std::vector<LayerGradients> grads;
+        double loss = 0.0;
+        std::size_t correct = 0;
+    };
+
+    // Runs one step over batch_rows rows; source.row(i) / source.label(i) give the i-th row's
+    // pixels (a float pointer, or a SparseRow for sparse batches) and label.
+    template <typename Source>
+    double run_step(std::size_t batch_rows, const Source& source, std::size_t* correct);
+
+    void reduce_gradients();
+
+    NeuralNetwork& network_;
+    SgdOptimizer& optimizer_;
+    TrainerConfig config_;
+    ThreadPool pool_;
+    std::vector<Worker> workers_;
+    std::mt19937 rng_;
+    std::vector<uint32_t> order_;
+};
+
+#endif // TRAINER_H
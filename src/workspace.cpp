@@ -0,0 +1,60 @@
+#include "workspace.h"
+
+#include <new>
+#include <stdexcept>
+#include <string>
+
+Workspace::Workspace() : data_(nullptr), capacity_(0), used_(0) {
+}
+
+Workspace::~Workspace() {
+    release();
+}
+
+Workspace::Workspace(Workspace&& other) noexcept
+    : data_(other.data_), capacity_(other.capacity_), used_(other.used_) {
+    other.data_ = nullptr;
+    other.capacity_ = other.used_ = 0;
+}
+
+Workspace& Workspace::operator=(Workspace&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = other.data_;
+        capacity_ = other.capacity_;
+        used_ = other.used_;
+        other.data_ = nullptr;
+        other.capacity_ = other.used_ = 0;
+    }
+    return *this;
+}
+
+void Workspace::reserve(std::size_t bytes) {
+    bytes = (bytes + kAlignment - 1) / kAlignment * kAlignment;
+    if (bytes > capacity_) {
+        release();
+        data_ = static_cast<unsigned char*>(::operator new(bytes, std::align_val_t(kAlignment)));
+        capacity_ = bytes;
+    }
+    used_ = 0;
+}
+
+void* Workspace::allocate_bytes(std::size_t bytes) {
+    bytes = (bytes + kAlignment - 1) / kAlignment * kAlignment;
+    if (bytes > capacity_ - used_) {
+        throw std::runtime_error("Workspace: " + std::to_string(bytes) + " bytes requested with " +
+                                 std::to_string(capacity_ - used_) + " of " + std::to_string(capacity_) +
+                                 " left; reserve() more.");
+    }
+    void* p = data_ + used_;
+    used_ += bytes;
+    return p;
+}
+
+void Workspace::release() {
+    if (data_ != nullptr) {
+        ::operator delete(data_, std::align_val_t(kAlignment));
+        data_ = nullptr;
+    }
+    capacity_ = used_ = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <cstddef>
+
+// Bump arena for per-pass scratch memory.
+// reserve() makes the only heap allocation: one 64-byte aligned block. allocate() then
+// hands out aligned slices of it in order, and reset() makes the whole block available
+// again without freeing it. A thread that sizes its workspace once from the network
+// topology and batch size can run any number of steps without touching the heap.
+class Workspace {
+public:
+    static constexpr std::size_t kAlignment = 64;
+
+    Workspace();
+    ~Workspace();
+
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+    Workspace(Workspace&& other) noexcept;
+    Workspace& operator=(Workspace&& other) noexcept;
+
+    // Ensures a capacity of at least `bytes` and resets. Reallocates only when growing,
+    // which invalidates every slice handed out before.
+    void reserve(std::size_t bytes);
+
+    // Releases every slice; the block is kept for reuse
+    void reset() { used_ = 0; }
+
+    // Aligned, uninitialized storage for n elements of T. Throws std::runtime_error if the
+    // reserved capacity is exhausted, rather than silently falling back to the heap.
+    template <typename T>
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(allocate_bytes(n * sizeof(T)));
+    }
+
+    std::size_t capacity() const { return capacity_; }
+    std::size_t used() const { return used_; }
+
+    // Bytes a slice of n elements of T occupies, including alignment padding; sum these to size reserve()
+    template <typename T>
+    static std::size_t bytes_for(std::size_t n) {
+        return (n * sizeof(T) + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+private:
+    void* allocate_bytes(std::size_t bytes);
+    void release();
+
+    unsigned char* data_;
+    std::size_t capacity_;
+    std::size_t used_;
+};
+
+#endif // WORKSPACE_H